@@ -0,0 +1,81 @@
+// Runtime benchmark: validate against parse on an argv filling two std::sets, the case validate
+// avoids the most work in (nothing is inserted or allocated).
+//     cmake --build <dir> --target cli151_bench_validate && <dir>/bench/cli151_bench_validate
+
+#include <cli151/cli151.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+struct options
+{
+	std::set<int> ints;
+	std::set<std::string_view> strs;
+};
+
+} // namespace
+
+template <>
+struct cli151::meta<options>
+{
+	using T = options;
+	constexpr static auto value = args{&T::ints, &T::strs};
+};
+
+namespace
+{
+
+constexpr int n_args = 100;
+constexpr int n_runs = 100'000;
+
+template <class F>
+auto time_runs(F run) -> double
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < n_runs; ++i)
+	{
+		if (!run())
+		{
+			std::abort();
+		}
+	}
+	const std::chrono::duration<double, std::nano> elapsed =
+		std::chrono::steady_clock::now() - start;
+	return elapsed.count() / n_runs;
+}
+
+} // namespace
+
+auto main() -> int
+{
+	std::vector<std::string> storage;
+	storage.reserve(n_args);
+	for (int i = 0; i < n_args / 2; ++i)
+	{
+		storage.push_back("--ints=" + std::to_string(i));
+		storage.push_back("--strs=value_" + std::to_string(i));
+	}
+	std::vector<const char*> argv{"bench"};
+	for (const auto& arg : storage)
+	{
+		argv.push_back(arg.c_str());
+	}
+	const auto argc = static_cast<int>(argv.size());
+
+	const double parse_ns =
+		time_runs([&] { return cli151::parse<options>(argc, argv.data()).has_value(); });
+	const double validate_ns =
+		time_runs([&] { return static_cast<bool>(cli151::validate<options>(argc, argv.data())); });
+
+	std::printf("%d args, %d runs\n", n_args, n_runs);
+	std::printf("parse:    %8.0f ns\n", parse_ns);
+	std::printf("validate: %8.0f ns (%.2fx parse)\n", validate_ns, validate_ns / parse_ns);
+}
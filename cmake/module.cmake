@@ -0,0 +1,20 @@
+# The cli151 module (import cli151;), for compilers with C++20 module support. The headers are
+# only included in the module's global module fragment, so targets linking cli151::module don't
+# parse them, or frozen, fmt and fast_float, in every translation unit.
+if (CMAKE_VERSION VERSION_LESS 3.28)
+    message(FATAL_ERROR "cli151: CLI151_BUILD_MODULE needs CMake 3.28 or later")
+endif()
+
+message(STATUS "cli151: Building the cli151 module")
+
+add_library(cli151_module)
+add_library(cli151::module ALIAS cli151_module)
+target_sources(cli151_module
+    PUBLIC
+        FILE_SET CXX_MODULES
+        BASE_DIRS ${CMAKE_CURRENT_LIST_DIR}/../modules
+        FILES ${CMAKE_CURRENT_LIST_DIR}/../modules/cli151.cppm
+)
+target_compile_features(cli151_module PUBLIC cxx_std_20)
+# Public so that the macros in macros.hpp can still be included alongside the import.
+target_link_libraries(cli151_module PUBLIC cli151)
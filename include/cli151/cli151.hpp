@@ -2,97 +2,251 @@
 
 #include <cli151/common.hpp>
 #include <cli151/detail/compat.hpp>
-#include <cli151/detail/helpers.hpp>
+#include <cli151/detail/events.hpp>
+#include <cli151/detail/fingerprint.hpp>
+#include <cli151/detail/owned.hpp>
+#include <cli151/detail/parser.hpp>
+#include <cli151/detail/to_argv.hpp>
+#include <cli151/detail/validate.hpp>
+#include <cli151/enum_bitset.hpp>
+#include <cli151/lazy_args.hpp>
+#include <cli151/option_registry.hpp>
+#include <cli151/parse.hpp>
+#include <cli151/values_view.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace cli151
 {
 
+// Like parse, but long keywords which aren't arguments of T are then looked up in registry, and
+// their values are handed to the registered sinks. Arguments of T take precedence over registered
+// options with the same name, and are parsed exactly as with parse.
 template <class T, class Stream = FILE*>
-auto parse(int argc, const char* const* argv, [[maybe_unused]] Stream errstream = stderr)
-	-> std::optional<T>
+auto parse_dynamic(int argc, const char* const* argv, const option_registry& registry,
+                   [[maybe_unused]] Stream errstream = stderr) -> std::optional<T>
 {
-	// T is probably an aggregate. We 0-initialize (or whichever type of initialization C++ calls
-	// this) the result to prevent random values from appearing. Not sure if this should be part of
-	// the public API, but could prevent some cryptic bugs.
+	static_assert(!detail::is_variant<T>::value, "parse_dynamic doesn't support subcommands");
+
 	T result{};
 
-	using dispatcher = detail::handler_dispatcher<T, Stream>;
+	if (!detail::parse_into(result, argc, argv, errstream,
+	                        detail::parse_options{.registry = &registry}))
+	{
+		return {};
+	}
 
-	std::array<bool, dispatcher::index_to_handler_map.size()> used{};
+	return result;
+}
 
-	// High level overview:
-	// - Figure out if this is positional or keyword
-	// - In either case, get the handler and the value to handle
-	// - Call the handler (which should advance the position to the next arg to look at)
+// Like parse, but only the structure of the args is checked (keywords, numbers of values, and
+// constraints). Fields taking a single value are converted when first accessed through the
+// result, see lazy_args::get.
+template <class T, class Stream = FILE*>
+auto parse_lazy(int argc, const char* const* argv, Stream errstream = stderr)
+	-> std::optional<lazy_args<T, Stream>>
+{
+	static_assert(!detail::is_variant<T>::value, "parse_lazy doesn't support subcommands");
+
+	return detail::lazy_parser<T, Stream>::parse(argc, argv, errstream);
+}
 
-	// Eventual TODO: We can probably compile out some of this code when one or more types of args
-	// are entirely missing, for example where all args are positional_required.
+// The index of the argument Memptr of T, as given to parse_events visitors. For an option group,
+// this is the index of its first argument.
+template <class T, auto Memptr>
+constexpr std::size_t arg_index =
+	detail::flat_range_of<T, Memptr>(std::make_index_sequence<meta<T>::value.n_args>()).first;
+
+// Parses argv without constructing a T. Each value is converted into a temporary and given, as it
+// is read, to visitor(std::integral_constant<std::size_t, I>, value), where I is the index of the
+// argument (see arg_index). Sets give one event per occurrence with a single element, optionals
+// give the contained value, and flags give true. Duplicates and constraints are checked as in
+// parse, so memory use doesn't grow with argc. Subcommands, as T or as a field, aren't supported.
+// Returns false on failure, after the events of the args before the error.
+template <class T, class Visitor, class Stream = FILE*>
+auto parse_events(int argc, const char* const* argv, Visitor&& visitor,
+                  [[maybe_unused]] Stream errstream = stderr) -> bool
+{
+	static_assert(!detail::is_variant<T>::value, "parse_events doesn't support subcommands");
 
-	// Skip over argv[0]
-	int arg_index = 1;
-	std::size_t next_positional_arg_to_parse = 0;
+	return detail::parse_events<T, Stream>(argc, argv, visitor, errstream);
+}
 
-	while (arg_index < argc)
+// Like parse, but every string in the result (string_views, C strings, and multi-value and
+// trailing args, including those inside sets, tuples, and optionals) is copied into a single
+// arena, so the result doesn't refer to argv and argv can be freed or reused. The arena is one
+// allocation, sized by a first pass over the parsed value, and owned by the result.
+template <class T, class Stream = FILE*>
+auto parse_owned(int argc, const char* const* argv, [[maybe_unused]] Stream errstream = stderr)
+	-> std::optional<owned<T>>
+{
+	auto result = parse<T>(argc, argv, errstream);
+	if (!result)
 	{
-		const std::string_view view = argv[arg_index];
+		return {};
+	}
 
-		if (view.starts_with("--"))
-		{
-			// Long form
-
-			const auto kw_result = detail::parse_long_keyword<T>(view, arg_index, errstream);
-			if (!kw_result)
-			{
-				return {};
-			}
-			const auto [handler_index, value] = *kw_result;
-			const auto handler = dispatcher::index_to_handler_map[handler_index];
-			if (!handler(result, argc, argv, value, arg_index, used[handler_index], errstream))
-			{
-				return {};
-			}
-		}
-		else if (view.starts_with('-'))
-		{
-			// Short form
-
-			const auto kw_result = detail::parse_short_keyword<T>(view, arg_index, errstream);
-			if (!kw_result)
-			{
-				return {};
-			}
-			const auto [handler_index, value] = *kw_result;
-			const auto handler = dispatcher::index_to_handler_map[handler_index];
-			if (!handler(result, argc, argv, value, arg_index, used[handler_index], errstream))
-			{
-				return {};
-			}
-		}
-		else
-		{
-			// Positional
+	const auto size = detail::measure_all(*result);
+	std::unique_ptr<char[]> arena;
+	if (size.bytes() > 0)
+	{
+		arena = std::make_unique_for_overwrite<char[]>(size.bytes());
+		detail::rebase_all(*result, {arena.get(), size.bytes()}, size);
+	}
+	return owned<T>{std::move(*result), std::move(arena)};
+}
 
-			if (next_positional_arg_to_parse >= dispatcher::positional_args_indexes.size())
-			{
-				// TODO: This may behave differently if there is a trailing container in T
-				detail::output(errstream, "Too many positional args");
-				return {};
-			}
+// Copies every string value refers to (as parse_owned does) into buffer, which must then outlive
+// value. Returns false, leaving value unchanged, if buffer is smaller than owned_size(value).
+template <class T>
+auto rebase_strings(T& value, std::span<char> buffer) -> bool
+{
+	const auto size = detail::measure_all(value);
+	if (size.bytes() > buffer.size())
+	{
+		return false;
+	}
+	detail::rebase_all(value, buffer, size);
+	return true;
+}
 
-			const auto handler_index =
-				dispatcher::positional_args_indexes[next_positional_arg_to_parse++];
+// The size of the buffer rebase_strings needs for value.
+template <class T>
+auto owned_size(const T& value) -> std::size_t
+{
+	return detail::measure_all(value).bytes();
+}
+
+struct validate_result
+{
+	bool ok;
+	// On failure, the index in argv of the arg being parsed (for keywords, the key), or argc if
+	// the error was only found after reading every arg (such as a missing required argument).
+	int error_index;
 
-			const auto handler = dispatcher::index_to_handler_map[handler_index];
+	explicit operator bool() const { return ok; }
+};
 
-			if (!handler(result, argc, argv, {}, arg_index, used[handler_index], errstream))
-			{
-				return {};
-			}
-		}
+// Checks argv as parse would, with the same error reporting, but without constructing a T. Values
+// are converted into temporaries, so numbers are range checked, but nothing is copied into sets or
+// other containers.
+template <class T, class Stream = FILE*>
+auto validate(int argc, const char* const* argv, [[maybe_unused]] Stream errstream = stderr)
+	-> validate_result
+{
+	int error_index = argc;
+	const bool ok = detail::validate_args<T>(argc, argv, errstream, error_index);
+	return {ok, error_index};
+}
+
+template <class T>
+struct known_args
+{
+	T value;
+	// The number of args in the out array given to parse_known, including argv[0]
+	int argc;
+};
+
+// Like parse, but unrecognized keyword args (with their values) and extra positional args are
+// passed through rather than being errors, so the rest can be handed to another parser.
+// argv[0] and the unrecognized args are copied, in order, to out, which needs room for argc
+// pointers. out may be argv itself, compacting it in place like GNU getopt, as long as T doesn't
+// contain multi-value or trailing args (which view argv directly).
+// An unrecognized keyword without a joined value (--key=value) is assumed to take the next arg as
+// its value, unless that starts with '-'. A "--" is passed through too, so that the args after it
+// remain positional.
+template <class T, class Stream = FILE*>
+auto parse_known(int argc, const char* const* argv, char** out,
+                 [[maybe_unused]] Stream errstream = stderr) -> std::optional<known_args<T>>
+{
+	static_assert(!detail::is_variant<T>::value, "parse_known doesn't support subcommands");
+
+	T result{};
+	detail::unknown_args unknown{out, 0};
+	if (argc > 0)
+	{
+		unknown.push(argv[0]);
 	}
 
-	return result;
+	if (!detail::parse_into(result, argc, argv, errstream, detail::parse_options{&unknown}))
+	{
+		return {};
+	}
+
+	return known_args<T>{result, unknown.count};
+}
+
+// The inverse of parse: writes args which parse back into value. Keyword args are written (as
+// --name=value) only where the field differs from a value initialized T, followed by "--" and the
+// positional and trailing args.
+// The tokens are written back to back, null terminated, into buffer, and pointers to them into
+// out, starting with prog_name and ending with a null pointer, ready for execv or posix_spawn.
+// Returns the number of args (not counting the null pointer), or std::nullopt if either buffer or
+// out is too small, or if a value can't be written such that it parses back the same.
+template <class T>
+auto to_argv(const T& value, std::string_view prog_name, std::span<char> buffer,
+             std::span<char*> out) -> std::optional<int>
+{
+	detail::argv_writer writer{buffer, out};
+	if (!writer.token(prog_name) ||
+	    !detail::write_args(writer, value, std::make_index_sequence<detail::n_flat_args<T>()>()))
+	{
+		return {};
+	}
+	out[static_cast<std::size_t>(writer.argc)] = nullptr;
+	return writer.argc;
+}
+
+// A 128 bit hash of the value of every argument, in the order of meta<T>, for use as a cache key.
+// Each type has a canonical encoding, so equal values hash equally however they were given (-n 8
+// or --num=08), and the elements of sets are combined independently of their order. Not suitable
+// where collisions could be forced deliberately.
+template <class T>
+auto fingerprint(const T& value) -> hash128
+{
+	detail::hasher h;
+	if constexpr (detail::is_variant<T>::value)
+	{
+		detail::hash_value(h, value);
+	}
+	else
+	{
+		detail::hash_struct(h, value);
+	}
+	return h.finish();
+}
+
+// The same as fingerprint(parse<T>(argc, argv)), with the same error reporting, but values taking
+// a single arg (see parse_lazy) are converted into temporaries rather than into a T.
+template <class T, class Stream = FILE*>
+auto fingerprint(int argc, const char* const* argv, [[maybe_unused]] Stream errstream = stderr)
+	-> std::optional<hash128>
+{
+	if constexpr (detail::is_variant<T>::value)
+	{
+		const auto value = parse<T>(argc, argv, errstream);
+		if (!value)
+		{
+			return {};
+		}
+		return fingerprint(*value);
+	}
+	else
+	{
+		const auto args = parse_lazy<T>(argc, argv, errstream);
+		if (!args)
+		{
+			return {};
+		}
+		return detail::lazy_fingerprinter<T, Stream>::hash(*args);
+	}
 }
 
 } // namespace cli151
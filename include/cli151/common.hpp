@@ -1,8 +1,8 @@
 #pragma once
 
-#include <cli151/detail/compat.hpp>
-
+#include <cstddef>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 
 namespace cli151
@@ -15,11 +15,22 @@ struct meta
 // Arbitrary string to indicate that a parameter should not change.
 // Mainly useful for if you want to change the abbr or arg_name fields
 // while keeping the default generated ones for previous fields.
-constexpr static std::string_view default_ = "<default>";
+inline constexpr std::string_view default_ = "<default>";
 
 // Indicates that the field should be omitted, i.e. no help text,
 // no abbreviated name, or no long name.
-constexpr static std::string_view none = "";
+inline constexpr std::string_view none = "";
+
+// An error stream which discards everything. Parsing with it doesn't touch any runtime state, so
+// it can be done in a constant expression, see parse.
+struct null_sink
+{};
+
+// Besides FILE*, output iterators of chars, and null_sink, any type can be an error stream by
+// providing (for ADL to find)
+//     auto report_error(Sink& sink, std::string_view text) -> void;
+// which is given each message in pieces, in order. Pass a pointer (with an overload taking a
+// Sink*) to keep the state in the caller, since error streams are copied.
 
 template <class T>
 struct usage_formatter
@@ -31,6 +42,39 @@ template <class T>
 struct help_formatter
 {};
 
+enum class error_type
+{
+	invalid_key,
+	not_a_number,
+	number_out_of_range,
+	too_many_positional_args,
+	not_enough_positional_args,
+	duplicate_arg,
+};
+
+struct error
+{
+	error_type type;
+	// The index in argv of the arg the error is about
+	int arg_index;
+};
+
+// Writes a full description of an error, with the usage and the available options.
+template <class T>
+struct error_formatter
+{
+	error err;
+	int argc;
+	const char* const* argv;
+};
+
+// Writes the parsed value of every argument, as key=value lines ({}) or JSON ({:j}).
+template <class T>
+struct dump_formatter
+{
+	const T& value;
+};
+
 enum class arg_type
 {
 	// The argument is determined by its position in the arguments, and is required
@@ -40,23 +84,51 @@ enum class arg_type
 	// The argument is determined by keyword (short or long), and is optional
 	keyword,
 	// Have the library guess. With no other information, the first argument passed in that is
-	// either a std::optional, a bool, or std::set-like is a keyword argument. Any arguments before
-	// that are positional, and any after are also keywords.
+	// either a std::optional, a bool, std::set-like, or a multi-value view (std::span or
+	// values_view) is a keyword argument. Any arguments before that are positional, and any after
+	// are also keywords.
 	// TODO: For the first draft, just try to get this guessing working. Guesses mixed with
 	// explicit arg types might be tricky.
 	guess,
+	// Captures the remainder of argv, either everything after "--" or everything starting from the
+	// first positional argument beyond the declared ones. Must be the last argument, and must be
+	// a std::span<const char* const> or values_view. Never guessed, it needs to be explicitly
+	// given.
+	trailing,
 
 	// Unbounded containers are sort of special, we'll have to consider them separately.
 	// std::optionals cannot be positional_required
 	// bools are always keyword
 };
 
+// Indicates that a field is not a single bit of a larger field.
+inline constexpr std::size_t no_bit = static_cast<std::size_t>(-1);
+
 struct opt
 {
 	std::string_view help = default_;
 	std::string_view abbr = default_;
 	std::string_view arg_name = default_;
 	arg_type type = arg_type::guess;
+	// Makes this a flag stored as a single bit of a std::bitset or unsigned integer field, which
+	// can be shared with other flags. As with bools, the bit is flipped when the flag is given.
+	// Since every flag sharing a field would reflect the same name, arg_name must be given.
+	std::size_t bit = no_bit;
+	// Makes a keyword argument required. Positional arguments are always required.
+	bool required = false;
+	// Arguments sharing the same (non-empty) group are mutually exclusive.
+	std::string_view exclusive_group = none;
+	// The name of another argument, which must be given whenever this one is.
+	std::string_view depends_on = none;
+	// Makes this a family of options sharing a prefix, such as -O2, -DNAME=1 or -I/usr/include.
+	// Any single dash arg starting with the prefix matches (the longest prefix, if several do),
+	// and the rest of the arg is the value. If nothing follows the prefix, the value is the next
+	// arg (-I /usr/include). Set-like fields collect every member of the family. The short name
+	// defaults to none, the long name still works as usual.
+	std::string_view prefix = none;
+	// Other names for this argument, space separated, with their dashes: "--num-threads -j".
+	// They all set the same field, and count as the same argument for duplicates and constraints.
+	std::string_view aliases = none;
 };
 
 template <class T>
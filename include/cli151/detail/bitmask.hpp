@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace cli151::detail
+{
+
+// A fixed size set of bits, usable at compile time (std::bitset is only constexpr from C++23).
+// Whole-set operations work a word at a time.
+template <std::size_t N>
+struct bitmask
+{
+	constexpr static std::size_t bits_per_word = 64;
+	constexpr static std::size_t n_words = N == 0 ? 1 : (N + bits_per_word - 1) / bits_per_word;
+
+	std::array<std::uint64_t, n_words> words{};
+
+	constexpr auto test(std::size_t i) const -> bool
+	{
+		return (words[i / bits_per_word] >> (i % bits_per_word)) & 1;
+	}
+
+	constexpr auto set(std::size_t i) -> void
+	{
+		words[i / bits_per_word] |= std::uint64_t{1} << (i % bits_per_word);
+	}
+
+	constexpr auto reset(std::size_t i) -> void
+	{
+		words[i / bits_per_word] &= ~(std::uint64_t{1} << (i % bits_per_word));
+	}
+
+	constexpr auto any() const -> bool
+	{
+		for (const auto word : words)
+		{
+			if (word != 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	constexpr auto count() const -> std::size_t
+	{
+		std::size_t result = 0;
+		for (const auto word : words)
+		{
+			result += static_cast<std::size_t>(std::popcount(word));
+		}
+		return result;
+	}
+
+	// Index of the lowest set bit, or N if there is none.
+	constexpr auto first() const -> std::size_t
+	{
+		for (std::size_t i = 0; i < n_words; ++i)
+		{
+			if (words[i] != 0)
+			{
+				return i * bits_per_word + static_cast<std::size_t>(std::countr_zero(words[i]));
+			}
+		}
+		return N;
+	}
+
+	friend constexpr auto operator&(const bitmask& lhs, const bitmask& rhs) -> bitmask
+	{
+		bitmask result;
+		for (std::size_t i = 0; i < n_words; ++i)
+		{
+			result.words[i] = lhs.words[i] & rhs.words[i];
+		}
+		return result;
+	}
+
+	friend constexpr auto operator|(const bitmask& lhs, const bitmask& rhs) -> bitmask
+	{
+		bitmask result;
+		for (std::size_t i = 0; i < n_words; ++i)
+		{
+			result.words[i] = lhs.words[i] | rhs.words[i];
+		}
+		return result;
+	}
+
+	// Complement, keeping bits past N cleared.
+	constexpr auto operator~() const -> bitmask
+	{
+		bitmask result;
+		for (std::size_t i = 0; i < n_words; ++i)
+		{
+			result.words[i] = ~words[i];
+		}
+		if constexpr (N % bits_per_word != 0)
+		{
+			result.words[n_words - 1] &= (std::uint64_t{1} << (N % bits_per_word)) - 1;
+		}
+		else if constexpr (N == 0)
+		{
+			result.words[0] = 0;
+		}
+		return result;
+	}
+
+	constexpr auto operator==(const bitmask&) const -> bool = default;
+};
+
+} // namespace cli151::detail
@@ -0,0 +1,26 @@
+#pragma once
+
+// std::from_chars, or fast_float where std::from_chars doesn't support floating point.
+
+#if !__has_include(<charconv>)
+#	define CLI151_HAS_FROM_CHARS false
+#else
+#	include <charconv> // IWYU pragma: keep (need charconv for __cpp_lib_to_chars)
+#	if !defined __cpp_lib_to_chars
+#		define CLI151_HAS_FROM_CHARS false
+#	endif
+#endif
+
+#ifdef CLI151_HAS_FROM_CHARS
+#	include <fast_float/fast_float.h>
+namespace cli151::compat
+{
+using fast_float::from_chars;
+}
+#else
+#	define CLI151_HAS_FROM_CHARS true
+namespace cli151::compat
+{
+using std::from_chars;
+}
+#endif
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <bitset>
+#include <cstddef>
 #include <optional>
+#include <span>
 #include <type_traits>
+#include <variant>
 
 namespace cli151::detail
 {
@@ -14,6 +18,14 @@ template <class T>
 struct is_optional<std::optional<T>> : std::true_type
 {};
 
+template <class T>
+struct is_variant : std::false_type
+{};
+
+template <class... Ts>
+struct is_variant<std::variant<Ts...>> : std::true_type
+{};
+
 template <class T>
 struct pointer_to_member
 {};
@@ -25,6 +37,24 @@ struct pointer_to_member<M C::*>
 	using member = M;
 };
 
+// Types which view a run of consecutive argv elements, rather than owning their values.
+template <class T>
+struct is_argv_view : std::false_type
+{};
+
+template <>
+struct is_argv_view<std::span<const char* const>> : std::true_type
+{};
+
+// Fields that single flags can be stored in, one bit each.
+template <class T>
+struct is_bit_storage : std::bool_constant<std::is_unsigned_v<T> && !std::is_same_v<T, bool>>
+{};
+
+template <std::size_t N>
+struct is_bit_storage<std::bitset<N>> : std::true_type
+{};
+
 template <class T>
 concept set_like = requires(T t, typename T::value_type e) { t.insert(e); };
 
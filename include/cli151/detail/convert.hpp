@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cli151/detail/compat_from_chars.hpp>
+#include <cli151/detail/enums.hpp>
+#include <cli151/detail/from_chars.hpp>
+#include <cli151/enum_bitset.hpp>
+
+#include <cstddef>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace cli151::detail
+{
+
+/*
+convert_value(str, out) -> std::errc
+Converts a single, already extracted argument. This is shared between the eager parsers and the
+views that convert on access.
+str: The text of the argument.
+out: If successful, the result is placed here. On error, no change.
+Returns std::errc() on success, otherwise an error code following the contract of std::from_chars.
+*/
+
+constexpr auto convert_value(std::string_view str, std::string_view& out) -> std::errc
+{
+	out = str;
+	return {};
+}
+
+// The view is always a suffix of an argv element, so it is null terminated.
+constexpr auto convert_value(std::string_view str, const char*& out) -> std::errc
+{
+	out = str.data();
+	return {};
+}
+
+template <class T>
+	requires((std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_floating_point_v<T>)
+constexpr auto convert_value(std::string_view str, T& out) -> std::errc
+{
+	if (std::is_constant_evaluated())
+	{
+		return constant_from_chars(str, out);
+	}
+	return compat::from_chars(str.data(), str.data() + str.size(), out).ec;
+}
+
+// Enums are given by the (kebabbed) enumerator name. Bitmask enums take a comma separated list of
+// names, which are OR-ed together.
+template <class E>
+	requires std::is_enum_v<E>
+constexpr auto convert_value(std::string_view str, E& out) -> std::errc
+{
+	constexpr auto& map = enum_lookup<E>::name_to_value_map;
+
+	if constexpr (is_bitmask_enum<E>())
+	{
+		E result{};
+		const auto add = [&](std::string_view name)
+		{
+			const auto it = map.find(name);
+			if (it == map.end())
+			{
+				return false;
+			}
+			result = enum_or(result, it->second);
+			return true;
+		};
+
+		if (!for_each_list_element(str, add))
+		{
+			return std::errc::invalid_argument;
+		}
+		out = result;
+	}
+	else
+	{
+		const auto it = map.find(str);
+		if (it == map.end())
+		{
+			return std::errc::invalid_argument;
+		}
+		out = it->second;
+	}
+	return {};
+}
+
+template <class E, std::size_t N>
+constexpr auto convert_value(std::string_view str, enum_bitset<E, N>& out) -> std::errc
+{
+	constexpr auto& map = enum_lookup<E>::name_to_value_map;
+
+	enum_bitset<E, N> result;
+	const auto add = [&](std::string_view name)
+	{
+		const auto it = map.find(name);
+		if (it == map.end())
+		{
+			return false;
+		}
+		result.set(it->second);
+		return true;
+	};
+
+	if (!for_each_list_element(str, add))
+	{
+		return std::errc::invalid_argument;
+	}
+	out = result;
+	return {};
+}
+
+} // namespace cli151::detail
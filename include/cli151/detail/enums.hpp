@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/reflect.hpp>
+
+#include <frozen/string.h>
+#include <frozen/unordered_map.h>
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace cli151::detail
+{
+
+// Enum information is reflected at compile time. meta<E> can optionally give:
+// - constexpr static bool bitmask: Every enumerator is a single bit. A comma separated list of
+//   names (--features=simd,numa) is OR-ed together.
+// - constexpr static int min, max: The inclusive range of values searched for enumerators.
+//   Defaults to [0, 127]. Unused for bitmasks, which search every bit of the underlying type.
+
+template <class E>
+consteval auto is_bitmask_enum() -> bool
+{
+	if constexpr (requires { meta<E>::bitmask; })
+	{
+		return meta<E>::bitmask;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+template <class E>
+consteval auto enum_search_min() -> long long
+{
+	if constexpr (requires { meta<E>::min; })
+	{
+		return meta<E>::min;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+template <class E>
+consteval auto enum_search_max() -> long long
+{
+	if constexpr (requires { meta<E>::max; })
+	{
+		return meta<E>::max;
+	}
+	else
+	{
+		return 127;
+	}
+}
+
+template <class E>
+consteval auto n_enum_candidates() -> std::size_t
+{
+	if constexpr (is_bitmask_enum<E>())
+	{
+		return std::numeric_limits<std::make_unsigned_t<std::underlying_type_t<E>>>::digits;
+	}
+	else
+	{
+		static_assert(enum_search_min<E>() <= enum_search_max<E>(), "Invalid enum search range");
+		return static_cast<std::size_t>(enum_search_max<E>() - enum_search_min<E>() + 1);
+	}
+}
+
+// The ith value to check for an enumerator
+template <class E>
+constexpr auto enum_candidate(std::size_t i) -> E
+{
+	using U = std::underlying_type_t<E>;
+	if constexpr (is_bitmask_enum<E>())
+	{
+		return static_cast<E>(static_cast<U>(std::make_unsigned_t<U>{1} << i));
+	}
+	else
+	{
+		return static_cast<E>(static_cast<U>(enum_search_min<E>() + static_cast<long long>(i)));
+	}
+}
+
+template <class E, std::size_t... Is>
+consteval auto enum_candidate_names(std::index_sequence<Is...>)
+	-> std::array<std::string_view, sizeof...(Is)>
+{
+	return {get_enum_value_name<enum_candidate<E>(Is)>()...};
+}
+
+// Reflected names and values of the enumerators of E, with names kebabbed like field names.
+template <class E>
+struct enum_info
+{
+  private:
+	constexpr static auto candidate_names =
+		enum_candidate_names<E>(std::make_index_sequence<n_enum_candidates<E>()>());
+
+	constexpr static auto count = []
+	{
+		std::size_t result = 0;
+		for (const auto name : candidate_names)
+		{
+			result += !name.empty();
+		}
+		return result;
+	}();
+
+	static_assert(count > 0, "No enumerators found. If the values are outside of [0, 127], set "
+	                         "the range to search with meta<E>::min and meta<E>::max");
+
+	constexpr static auto total_size = []
+	{
+		std::size_t result = 0;
+		for (const auto name : candidate_names)
+		{
+			result += name.size();
+		}
+		return result;
+	}();
+
+	constexpr static auto storage = []
+	{
+		std::array<char, total_size> result{};
+		std::size_t pos = 0;
+		for (const auto name : candidate_names)
+		{
+			for (const char c : name)
+			{
+				result[pos++] = c == '_' ? '-' : c;
+			}
+		}
+		return result;
+	}();
+
+  public:
+	constexpr static auto names = []
+	{
+		std::array<std::string_view, count> result{};
+		std::size_t index = 0;
+		std::size_t pos = 0;
+		for (const auto name : candidate_names)
+		{
+			if (!name.empty())
+			{
+				result[index++] = {storage.data() + pos, name.size()};
+				pos += name.size();
+			}
+		}
+		return result;
+	}();
+
+	constexpr static auto values = []
+	{
+		std::array<E, count> result{};
+		std::size_t index = 0;
+		for (std::size_t i = 0; i < candidate_names.size(); ++i)
+		{
+			if (!candidate_names[i].empty())
+			{
+				result[index++] = enum_candidate<E>(i);
+			}
+		}
+		return result;
+	}();
+
+	// Gives the name of a single enumerator, or an empty string if there is none.
+	constexpr static auto name_of(E value) -> std::string_view
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (values[i] == value)
+			{
+				return names[i];
+			}
+		}
+		return {};
+	}
+};
+
+template <class E, class Seq>
+struct enum_lookup_impl
+{};
+
+template <class E, std::size_t... Is>
+struct enum_lookup_impl<E, std::index_sequence<Is...>>
+{
+	// Maps the names of the enumerators of E to their values.
+	constexpr static auto name_to_value_map = frozen::make_unordered_map(std::array{
+		std::pair{frozen::string{enum_info<E>::names[Is]}, enum_info<E>::values[Is]}...,
+	});
+};
+
+template <class E>
+using enum_lookup =
+	enum_lookup_impl<E, std::make_index_sequence<enum_info<E>::names.size()>>;
+
+// The bit of value in an enum_bitset of E. Bits start at the bottom of the search range (see
+// meta<E>::min), so negative enumerators have bits too.
+template <class E>
+constexpr auto enum_bit_index(E value) -> std::size_t
+{
+	return static_cast<std::size_t>(static_cast<long long>(value) - enum_search_min<E>());
+}
+
+// Number of bits needed to index by the values of E
+template <class E>
+consteval auto enum_bit_count() -> std::size_t
+{
+	static_assert(!is_bitmask_enum<E>(), "Bitmask enums are already sets of bits");
+	std::size_t result = 0;
+	for (const auto value : enum_info<E>::values)
+	{
+		const auto bit = enum_bit_index(value) + 1;
+		result = bit > result ? bit : result;
+	}
+	return result;
+}
+
+// Specialized by cli151::enum_bitset.
+template <class T>
+struct is_enum_bitset : std::false_type
+{};
+
+// The enum of a bitmask enum (itself) or enum_bitset.
+template <class T>
+struct flag_enum
+{
+	using type = T;
+};
+
+template <class T>
+	requires is_enum_bitset<T>::value
+struct flag_enum<T>
+{
+	using type = typename T::enum_type;
+};
+
+// Types filled from a comma separated list of enumerator names, accumulating when repeated.
+template <class T>
+concept enum_flags = (std::is_enum_v<T> && is_bitmask_enum<T>()) || is_enum_bitset<T>::value;
+
+template <class E>
+constexpr auto enum_or(E lhs, E rhs) -> E
+{
+	using U = std::underlying_type_t<E>;
+	return static_cast<E>(static_cast<U>(static_cast<U>(lhs) | static_cast<U>(rhs)));
+}
+
+// Calls f(name) for each element of a comma separated list. Stops and returns false as soon as f
+// returns false.
+constexpr auto for_each_list_element(std::string_view list, auto f) -> bool
+{
+	while (true)
+	{
+		const auto comma_pos = list.find(',');
+		if (!f(list.substr(0, comma_pos)))
+		{
+			return false;
+		}
+		if (comma_pos == std::string_view::npos)
+		{
+			return true;
+		}
+		list.remove_prefix(comma_pos + 1);
+	}
+}
+
+} // namespace cli151::detail
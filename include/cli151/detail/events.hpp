@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/fields.hpp>
+#include <cli151/detail/handlers.hpp>
+#include <cli151/detail/helpers.hpp>
+#include <cli151/detail/parser.hpp>
+#include <cli151/detail/validate.hpp>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cli151::detail
+{
+
+template <class T, class Stream, class Visitor, class Seq>
+struct event_dispatcher_impl
+{};
+
+template <class T, class Stream, class Visitor, std::size_t... Is>
+struct event_dispatcher_impl<T, Stream, Visitor, std::index_sequence<Is...>>
+{
+	// Same as parse_value_into_struct, except the value is converted into a temporary (see
+	// scratch_type) and given to the visitor. Flags are given as true.
+	template <std::size_t I>
+	static auto emit(Visitor& visitor, const int argc, const char* const* argv,
+	                 std::optional<std::string_view> current_value, int& current_index,
+	                 used_args_t<T>& used, Stream errstream) -> bool
+	{
+		using field = flat_arg<T, I>;
+		using owner = typename field::owner;
+		using M = member_type_of<owner, field::index>;
+
+		static_assert(!is_variant<M>::value, "parse_events doesn't support subcommands");
+
+		if (!mark_used<T, I>(used, errstream))
+		{
+			return false;
+		}
+
+		if constexpr (std::get<field::index>(meta<owner>::value.args_).options.bit != no_bit)
+		{
+			visitor(std::integral_constant<std::size_t, I>(), true);
+			return true;
+		}
+		else
+		{
+			typename scratch_type<M>::type scratch{};
+			if (!parse_field_value<T>(scratch, argc, argv, current_value, current_index,
+			                          errstream))
+			{
+				return false;
+			}
+			visitor(std::integral_constant<std::size_t, I>(), std::as_const(scratch));
+			return true;
+		}
+	}
+
+	using emitter_t = auto (*)(Visitor&, int, const char* const*, std::optional<std::string_view>,
+	                           int&, used_args_t<T>&, Stream) -> bool;
+
+	constexpr static std::array<emitter_t, sizeof...(Is)> index_to_emitter_map{
+		emit<Is>...,
+	};
+};
+
+template <class T, class Stream, class Visitor>
+using event_dispatcher =
+	event_dispatcher_impl<T, Stream, Visitor, std::make_index_sequence<n_flat_args<T>()>>;
+
+template <class T, class Stream, class Visitor>
+auto parse_events(int argc, const char* const* argv, Visitor& visitor, Stream errstream) -> bool
+{
+	const auto handle = [&](std::size_t handler_index, std::optional<std::string_view> value,
+	                        int& arg_index, used_args_t<T>& used)
+	{
+		const auto emitter =
+			event_dispatcher<T, Stream, Visitor>::index_to_emitter_map[handler_index];
+		return emitter(visitor, argc, argv, value, arg_index, used, errstream);
+	};
+
+	const auto set_trailing = [&](std::span<const char* const> rest)
+	{
+		if constexpr (trailing_arg_index<T>() < n_flat_args<T>())
+		{
+			constexpr auto index = trailing_arg_index<T>();
+			using field = flat_arg<T, index>;
+			using M = member_type_of<typename field::owner, field::index>;
+			const M value{rest};
+			visitor(std::integral_constant<std::size_t, index>(), value);
+		}
+	};
+
+	return parse_args<T>(argc, argv, errstream, parse_options{}, handle, set_trailing);
+}
+
+} // namespace cli151::detail
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/concepts.hpp>
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cli151::detail
+{
+
+// A field whose type has its own meta<> is an option group: its arguments are parsed as if they
+// were declared in the outer struct, in place of the field. Groups can nest.
+template <class T>
+concept option_group = requires { meta<T>::value.n_args; };
+
+template <class T, std::size_t N>
+using member_type_of =
+	typename pointer_to_member<decltype(std::get<N>(meta<T>::value.args_).memptr)>::member;
+
+template <class T, std::size_t... Is>
+consteval auto flat_arg_counts(std::index_sequence<Is...>)
+	-> std::array<std::size_t, sizeof...(Is)>;
+
+// Number of arguments of T once all option groups are expanded.
+template <class T>
+consteval auto n_flat_args() -> std::size_t
+{
+	std::size_t result = 0;
+	for (const auto count : flat_arg_counts<T>(std::make_index_sequence<meta<T>::value.n_args>()))
+	{
+		result += count;
+	}
+	return result;
+}
+
+template <class T, std::size_t... Is>
+consteval auto flat_arg_counts(std::index_sequence<Is...>) -> std::array<std::size_t, sizeof...(Is)>
+{
+	const auto count = []<std::size_t N>(std::integral_constant<std::size_t, N>)
+	{
+		if constexpr (option_group<member_type_of<T, N>>)
+		{
+			return n_flat_args<member_type_of<T, N>>();
+		}
+		else
+		{
+			return std::size_t{1};
+		}
+	};
+	return {count(std::integral_constant<std::size_t, Is>())...};
+}
+
+// Finds the argument of T containing the Ith flat argument, and the position of the Ith flat
+// argument within it.
+template <class T, std::size_t I>
+consteval auto locate_flat_arg() -> std::pair<std::size_t, std::size_t>
+{
+	const auto counts = flat_arg_counts<T>(std::make_index_sequence<meta<T>::value.n_args>());
+	std::size_t offset = I;
+	std::size_t index = 0;
+	while (offset >= counts[index])
+	{
+		offset -= counts[index++];
+	}
+	return {index, offset};
+}
+
+template <class T, std::size_t I,
+          bool = option_group<member_type_of<T, locate_flat_arg<T, I>().first>>>
+struct flat_arg;
+
+// The Ith argument of T, counting the arguments of option groups in place. owner is the struct
+// that declares the argument, and index is its position in meta<owner>. All per-argument
+// information (names, guessed types) is computed in terms of the owner, so a group behaves the
+// same regardless of where it is included.
+template <class T, std::size_t I>
+struct flat_arg<T, I, false>
+{
+	using owner = T;
+	constexpr static std::size_t index = locate_flat_arg<T, I>().first;
+
+	constexpr static auto get(T& out) -> T& { return out; }
+	constexpr static auto get(const T& out) -> const T& { return out; }
+};
+
+template <class T, std::size_t I>
+struct flat_arg<T, I, true>
+{
+  private:
+	constexpr static auto location = locate_flat_arg<T, I>();
+	constexpr static auto memptr = std::get<location.first>(meta<T>::value.args_).memptr;
+	using inner = flat_arg<member_type_of<T, location.first>, location.second>;
+
+  public:
+	using owner = typename inner::owner;
+	constexpr static std::size_t index = inner::index;
+
+	constexpr static auto get(T& out) -> owner& { return inner::get(out.*memptr); }
+	constexpr static auto get(const T& out) -> const owner& { return inner::get(out.*memptr); }
+};
+
+// Intentionally not constexpr, see flat_range_of
+inline auto field_is_not_an_argument() -> void {}
+
+// The flat arguments [first, first + second) of T which belong to the field Memptr.
+template <class T, auto Memptr, std::size_t... Is>
+consteval auto flat_range_of(std::index_sequence<Is...>) -> std::pair<std::size_t, std::size_t>
+{
+	static_assert(std::is_same_v<typename pointer_to_member<decltype(Memptr)>::class_, T>,
+	              "Not a field of T");
+
+	constexpr auto counts = flat_arg_counts<T>(std::index_sequence<Is...>());
+
+	std::size_t index = sizeof...(Is);
+	const auto check = [&]<std::size_t I>()
+	{
+		constexpr auto memptr = std::get<I>(meta<T>::value.args_).memptr;
+		if constexpr (std::is_same_v<std::remove_const_t<decltype(memptr)>, decltype(Memptr)>)
+		{
+			if (index == sizeof...(Is) && memptr == Memptr)
+			{
+				index = I;
+			}
+		}
+	};
+	(check.template operator()<Is>(), ...);
+
+	if (index == sizeof...(Is))
+	{
+		// Not a constant expression, so this is a compile error.
+		field_is_not_an_argument();
+	}
+
+	std::size_t first = 0;
+	for (std::size_t i = 0; i < index; ++i)
+	{
+		first += counts[i];
+	}
+	return {first, counts[index]};
+}
+
+} // namespace cli151::detail
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/enums.hpp>
+#include <cli151/detail/fields.hpp>
+#include <cli151/detail/handlers.hpp>
+#include <cli151/lazy_args.hpp>
+#include <cli151/values_view.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace cli151
+{
+
+// A 128 bit hash, see fingerprint.
+struct hash128
+{
+	std::uint64_t low = 0;
+	std::uint64_t high = 0;
+
+	constexpr auto operator==(const hash128&) const -> bool = default;
+};
+
+} // namespace cli151
+
+namespace cli151::detail
+{
+
+// Streaming 128 bit hash over 64 bit words, with the round and finalizer of MurmurHash3_x64_128.
+// Fast and well distributed, but not cryptographic.
+class hasher
+{
+  public:
+	constexpr auto add(std::uint64_t word) -> void
+	{
+		h1 ^= std::rotl(word * c1, 31) * c2;
+		h1 = (std::rotl(h1, 27) + h2) * 5 + 0x52dce729;
+		h2 ^= std::rotl(word * c2, 33) * c1;
+		h2 = (std::rotl(h2, 31) + h1) * 5 + 0x38495ab5;
+		++n_words;
+	}
+
+	// The length, then the bytes 8 at a time (little endian, so the result doesn't depend on the
+	// platform).
+	constexpr auto add_string(std::string_view str) -> void
+	{
+		add(str.size());
+		while (!str.empty())
+		{
+			const auto n = str.size() < 8 ? str.size() : 8;
+			std::uint64_t word = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				word |= std::uint64_t{static_cast<unsigned char>(str[i])} << (8 * i);
+			}
+			add(word);
+			str.remove_prefix(n);
+		}
+	}
+
+	constexpr auto finish() const -> hash128
+	{
+		auto a = h1 ^ n_words;
+		auto b = h2 ^ n_words;
+		a += b;
+		b += a;
+		a = fmix(a);
+		b = fmix(b);
+		a += b;
+		b += a;
+		return {a, b};
+	}
+
+  private:
+	constexpr static std::uint64_t c1 = 0x87c37b91114253d5;
+	constexpr static std::uint64_t c2 = 0x4cf5ad432745937f;
+
+	constexpr static auto fmix(std::uint64_t k) -> std::uint64_t
+	{
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccd;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53;
+		k ^= k >> 33;
+		return k;
+	}
+
+	std::uint64_t h1 = 0x9e3779b97f4a7c15;
+	std::uint64_t h2 = 0x6a09e667f3bcc909;
+	std::uint64_t n_words = 0;
+};
+
+template <class T>
+auto hash_struct(hasher& h, const T& value) -> void;
+
+/*
+hash_value(h, value) -> void
+Adds the canonical encoding of a value. Each encoding is self delimiting (strings and lists start
+with their size, optionals with whether they have a value), so a struct is just its fields in
+order.
+*/
+
+inline auto hash_value(hasher& h, std::string_view value) -> void
+{
+	h.add_string(value);
+}
+
+inline auto hash_value(hasher& h, const char* value) -> void
+{
+	h.add(value != nullptr);
+	if (value != nullptr)
+	{
+		h.add_string(value);
+	}
+}
+
+template <class T>
+	requires std::is_integral_v<T>
+auto hash_value(hasher& h, T value) -> void
+{
+	h.add(static_cast<std::uint64_t>(value));
+}
+
+template <class T>
+	requires std::is_floating_point_v<T>
+auto hash_value(hasher& h, T value) -> void
+{
+	// -0.0 == 0.0, so they should hash the same
+	const double normalized = value == 0 ? 0.0 : static_cast<double>(value);
+	h.add(std::bit_cast<std::uint64_t>(normalized));
+}
+
+template <class E>
+	requires std::is_enum_v<E>
+auto hash_value(hasher& h, E value) -> void
+{
+	h.add(static_cast<std::uint64_t>(value));
+}
+
+template <class E, std::size_t N>
+auto hash_value(hasher& h, const enum_bitset<E, N>& value) -> void
+{
+	h.add(value.count());
+	for (std::size_t i = 0; i < N; ++i)
+	{
+		if (value.test(i))
+		{
+			h.add(i);
+		}
+	}
+}
+
+// pair / tuple / array
+template <class T>
+	requires requires { std::tuple_size<T>::value; }
+auto hash_value(hasher& h, const T& value) -> void
+{
+	std::apply([&](const auto&... elements) { (hash_value(h, elements), ...); }, value);
+}
+
+inline auto hash_value(hasher& h, std::span<const char* const> value) -> void
+{
+	h.add(value.size());
+	for (const auto arg : value)
+	{
+		h.add_string(arg);
+	}
+}
+
+template <class T>
+auto hash_value(hasher& h, const values_view<T>& value) -> void
+{
+	hash_value(h, value.raw());
+}
+
+template <class T>
+auto hash_value(hasher& h, const std::optional<T>& value) -> void
+{
+	h.add(value.has_value());
+	if (value)
+	{
+		hash_value(h, *value);
+	}
+}
+
+// Each element is hashed on its own, and the results are summed, so the order of iteration (for
+// example of an unordered_set) doesn't matter.
+template <set_like T>
+auto hash_value(hasher& h, const T& value) -> void
+{
+	hash128 sum;
+	for (const auto& element : value)
+	{
+		hasher element_hasher;
+		hash_value(element_hasher, element);
+		const auto element_hash = element_hasher.finish();
+		sum.low += element_hash.low;
+		sum.high += element_hash.high;
+	}
+	h.add(value.size());
+	h.add(sum.low);
+	h.add(sum.high);
+}
+
+template <class... Ts>
+auto hash_value(hasher& h, const std::variant<Ts...>& value) -> void
+{
+	h.add(value.index());
+	std::visit([&](const auto& command) { hash_struct(h, command); }, value);
+}
+
+// The Ith (flat) argument of value.
+template <class T, std::size_t I>
+auto hash_arg(hasher& h, const T& value) -> void
+{
+	using field = flat_arg<T, I>;
+	constexpr auto info = std::get<field::index>(meta<typename field::owner>::value.args_);
+	const auto& member = field::get(value).*info.memptr;
+
+	if constexpr (info.options.bit != no_bit)
+	{
+		if constexpr (std::is_unsigned_v<std::remove_cvref_t<decltype(member)>>)
+		{
+			h.add((member >> info.options.bit) & 1);
+		}
+		else
+		{
+			h.add(member.test(info.options.bit));
+		}
+	}
+	else
+	{
+		hash_value(h, member);
+	}
+}
+
+template <class T, std::size_t... Is>
+auto hash_struct_impl(hasher& h, const T& value, std::index_sequence<Is...>) -> void
+{
+	(hash_arg<T, Is>(h, value), ...);
+}
+
+template <class T>
+auto hash_struct(hasher& h, const T& value) -> void
+{
+	hash_struct_impl(h, value, std::make_index_sequence<n_flat_args<T>()>());
+}
+
+// Hashes the result of parse_lazy without converting into it: the lazy args which were given are
+// converted into temporaries, and everything else is already in the cache.
+template <class T, class Stream, std::size_t... Is>
+struct lazy_fingerprinter_impl<T, Stream, std::index_sequence<Is...>>
+{
+	template <std::size_t I>
+	static auto hash(hasher& h, const lazy_args<T, Stream>& args) -> bool
+	{
+		if constexpr (is_lazy_arg<T, I>())
+		{
+			if (args.pending.test(I))
+			{
+				using field = flat_arg<T, I>;
+				member_type_of<typename field::owner, field::index> value{};
+				// The value is always given, so argv is never read.
+				int unused_index = 0;
+				if (!parse_value(value, 0, nullptr, args.values[I], unused_index, args.errstream))
+				{
+					return false;
+				}
+				hash_value(h, value);
+				return true;
+			}
+		}
+		hash_arg<T, I>(h, args.cache);
+		return true;
+	}
+
+	static auto hash(const lazy_args<T, Stream>& args) -> std::optional<hash128>
+	{
+		hasher h;
+		if (!(hash<Is>(h, args) && ...))
+		{
+			return {};
+		}
+		return h.finish();
+	}
+};
+
+template <class T, class Stream>
+using lazy_fingerprinter =
+	lazy_fingerprinter_impl<T, Stream, std::make_index_sequence<n_flat_args<T>()>>;
+
+} // namespace cli151::detail
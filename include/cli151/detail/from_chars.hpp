@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace cli151::detail
+{
+
+/*
+constant_from_chars(str, out) -> std::errc
+Base 10 number parsing for constant evaluation, where std::from_chars can't be used (it's only
+constexpr for integers from C++23, and fast_float isn't constexpr at all). Follows the contract
+of std::from_chars: a leading '-' is only allowed for signed types, parsing stops at the first
+char which can't be part of the number, and the result is std::errc::invalid_argument if there
+are no digits, or std::errc::result_out_of_range if the value doesn't fit.
+*/
+
+template <class T>
+	requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+constexpr auto constant_from_chars(std::string_view str, T& out) -> std::errc
+{
+	using U = std::make_unsigned_t<T>;
+
+	const bool negative = std::is_signed_v<T> && str.starts_with('-');
+	if (negative)
+	{
+		str.remove_prefix(1);
+	}
+	// The magnitude of the most negative value is one more than the maximum.
+	const auto limit =
+		static_cast<U>(static_cast<U>(std::numeric_limits<T>::max()) + (negative ? 1u : 0u));
+
+	U value = 0;
+	bool overflow = false;
+	std::size_t n_digits = 0;
+	for (; n_digits < str.size() && str[n_digits] >= '0' && str[n_digits] <= '9'; ++n_digits)
+	{
+		const auto digit = static_cast<U>(str[n_digits] - '0');
+		if (value > (limit - digit) / 10)
+		{
+			overflow = true;
+		}
+		else
+		{
+			value = static_cast<U>(value * 10 + digit);
+		}
+	}
+
+	if (n_digits == 0)
+	{
+		return std::errc::invalid_argument;
+	}
+	if (overflow)
+	{
+		return std::errc::result_out_of_range;
+	}
+	if (negative && value != 0)
+	{
+		// Negated as value - 1 first, so that the most negative value doesn't overflow.
+		out = static_cast<T>(-static_cast<T>(value - 1) - 1);
+	}
+	else
+	{
+		out = static_cast<T>(value);
+	}
+	return {};
+}
+
+// Intentionally not constexpr, see constant_from_chars
+inline auto number_is_not_exact_at_compile_time() -> void {}
+
+// The largest integer that T (and std::uint64_t) holds exactly, with every smaller one.
+template <class T>
+consteval auto max_exact_mantissa() -> std::uint64_t
+{
+	constexpr auto digits = std::numeric_limits<T>::digits;
+	return digits >= 64 ? std::numeric_limits<std::uint64_t>::max() : std::uint64_t{1} << digits;
+}
+
+// The largest e for which 10^e is exactly representable in T, that is, 5^e fits in the mantissa.
+template <class T>
+consteval auto max_exact_power_of_10() -> int
+{
+	int result = 0;
+	for (std::uint64_t power_of_5 = 5; power_of_5 <= max_exact_mantissa<T>(); power_of_5 *= 5)
+	{
+		++result;
+		if (power_of_5 > max_exact_mantissa<T>() / 5)
+		{
+			break;
+		}
+	}
+	return result;
+}
+
+// Only numbers that can be converted exactly (Clinger's fast path) are supported: at most 19
+// significant digits, forming an integer which fits in the mantissa of T, scaled by a power of 10
+// which does too. Those are correctly rounded by a single multiplication or division, so the
+// result is the same as at runtime. Anything else stops the constant evaluation rather than
+// risking a different result, including inf and nan, which std::from_chars accepts.
+template <class T>
+	requires std::is_floating_point_v<T>
+constexpr auto constant_from_chars(std::string_view str, T& out) -> std::errc
+{
+	const bool negative = str.starts_with('-');
+	if (negative)
+	{
+		str.remove_prefix(1);
+	}
+
+	// Case insensitive, word is lower case
+	const auto starts_with_word = [&](std::string_view word)
+	{
+		if (str.size() < word.size())
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < word.size(); ++i)
+		{
+			if ((str[i] | 0x20) != word[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+	if (starts_with_word("inf") || starts_with_word("nan"))
+	{
+		number_is_not_exact_at_compile_time();
+	}
+
+	std::uint64_t mantissa = 0;
+	int n_significant = 0;
+	int exponent = 0;
+	bool any_digits = false;
+	bool seen_point = false;
+	std::size_t i = 0;
+	for (; i < str.size(); ++i)
+	{
+		const char c = str[i];
+		if (c == '.' && !seen_point)
+		{
+			seen_point = true;
+			continue;
+		}
+		if (c < '0' || c > '9')
+		{
+			break;
+		}
+		any_digits = true;
+		if (mantissa == 0 && c == '0')
+		{
+			// Leading zeros aren't significant, only their position is.
+			exponent -= seen_point ? 1 : 0;
+			continue;
+		}
+		if (n_significant == 19)
+		{
+			// Only trailing zeros fit, as a larger exponent
+			if (c != '0')
+			{
+				number_is_not_exact_at_compile_time();
+			}
+			exponent += seen_point ? 0 : 1;
+			continue;
+		}
+		mantissa = mantissa * 10 + static_cast<std::uint64_t>(c - '0');
+		++n_significant;
+		exponent -= seen_point ? 1 : 0;
+	}
+	if (!any_digits)
+	{
+		return std::errc::invalid_argument;
+	}
+
+	// An exponent only counts if it has digits, otherwise parsing stops at the 'e'.
+	if (i < str.size() && (str[i] == 'e' || str[i] == 'E'))
+	{
+		auto rest = str.substr(i + 1);
+		const bool plus = rest.starts_with('+');
+		if (plus)
+		{
+			rest.remove_prefix(1);
+		}
+		int explicit_exponent = 0;
+		if (!(plus && rest.starts_with('-')))
+		{
+			const auto ec = constant_from_chars(rest, explicit_exponent);
+			if (ec == std::errc::result_out_of_range)
+			{
+				number_is_not_exact_at_compile_time();
+			}
+			exponent += explicit_exponent;
+		}
+	}
+
+	T result = 0;
+	if (mantissa != 0)
+	{
+		constexpr auto max_power = max_exact_power_of_10<T>();
+		if (mantissa > max_exact_mantissa<T>() || exponent > max_power || exponent < -max_power)
+		{
+			number_is_not_exact_at_compile_time();
+		}
+		T scale = 1;
+		for (int e = exponent < 0 ? -exponent : exponent; e > 0; --e)
+		{
+			scale *= 10;
+		}
+		result = static_cast<T>(mantissa);
+		result = exponent < 0 ? result / scale : result * scale;
+	}
+	out = negative ? -result : result;
+	return {};
+}
+
+} // namespace cli151::detail
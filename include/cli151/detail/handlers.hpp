@@ -1,25 +1,43 @@
 #pragma once
 
 #include <cli151/common.hpp>
-#include <cli151/detail/compat.hpp>
+#include <cli151/detail/bitmask.hpp>
+#include <cli151/detail/compat_from_chars.hpp>
 #include <cli151/detail/concepts.hpp>
+#include <cli151/detail/convert.hpp>
+#include <cli151/detail/fields.hpp>
 #include <cli151/detail/output.hpp>
+#include <cli151/detail/token_kind.hpp>
+#include <cli151/values_view.hpp>
 
 #include <array>
 #include <cassert>
 #include <optional>
+#include <span>
 #include <string_view>
+#include <system_error>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <variant>
 
 namespace cli151::detail
 {
 
+// Defined in parser.hpp and subcommands.hpp, needed for subcommand fields.
+template <class T, class Stream>
+constexpr auto parse_into(T& result, int argc, const char* const* argv, Stream errstream) -> bool;
+template <class Stream, class... Ts>
+constexpr auto parse_into(std::variant<Ts...>& result, int argc, const char* const* argv,
+                          Stream errstream) -> bool;
+template <class Stream, class... Ts>
+constexpr auto parse_subcommand(std::variant<Ts...>& out, int argc, const char* const* argv,
+                                Stream errstream) -> bool;
+
 template <class Stream>
-auto get_next_value(const int argc, const char* const* argv,
-                    std::optional<std::string_view> current_value, int& current_index,
-                    Stream errstream) -> std::optional<std::string_view>
+constexpr auto get_next_value(const int argc, const char* const* argv,
+                              std::optional<std::string_view> current_value, int& current_index,
+                              Stream errstream) -> std::optional<std::string_view>
 {
 	if (current_value.has_value())
 	{
@@ -48,9 +66,9 @@ current_index: The next index to read from argv, if needed.
 */
 
 template <class Stream>
-auto parse_value(std::string_view& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(std::string_view& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	auto result = get_next_value(argc, argv, current_value, current_index, errstream);
 	if (result)
@@ -61,9 +79,9 @@ auto parse_value(std::string_view& out, const int argc, const char* const* argv,
 }
 
 template <class Stream>
-auto parse_value(const char*& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(const char*& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	auto result = get_next_value(argc, argv, current_value, current_index, errstream);
 	if (result)
@@ -75,9 +93,9 @@ auto parse_value(const char*& out, const int argc, const char* const* argv,
 
 template <class T, class Stream>
 	requires(std::is_integral_v<T> || std::is_floating_point_v<T>)
-auto parse_value(T& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(T& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	auto result = get_next_value(argc, argv, current_value, current_index, errstream);
 	if (!result)
@@ -85,7 +103,7 @@ auto parse_value(T& out, const int argc, const char* const* argv,
 		return false;
 	}
 
-	const auto [ptr, ec] = compat::from_chars(result->data(), result->data() + result->size(), out);
+	const auto ec = convert_value(*result, out);
 
 	if (ec == std::errc())
 	{
@@ -106,11 +124,72 @@ auto parse_value(T& out, const int argc, const char* const* argv,
 	return false;
 }
 
+template <class E, class Stream>
+constexpr auto output_enum_choices(Stream errstream, std::string_view value, bool is_list) -> void
+{
+	if (is_list)
+	{
+		output(errstream, "Invalid value ({}), expected a comma separated list of:", value);
+	}
+	else
+	{
+		output(errstream, "Invalid value ({}), expected one of:", value);
+	}
+
+	for (const auto name : enum_info<E>::names)
+	{
+		output(errstream, " {}", name);
+	}
+}
+
+// Plain enums, bitmask enums, and enum_bitset. The last two accumulate when repeated.
+template <class E, class Stream>
+	requires(std::is_enum_v<E> || is_enum_bitset<E>::value)
+constexpr auto parse_value(E& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
+{
+	auto result = get_next_value(argc, argv, current_value, current_index, errstream);
+	if (!result)
+	{
+		return false;
+	}
+
+	E value{};
+	if (convert_value(*result, value) != std::errc())
+	{
+		if constexpr (is_enum_bitset<E>::value)
+		{
+			output_enum_choices<typename E::enum_type>(errstream, *result, true);
+		}
+		else
+		{
+			output_enum_choices<E>(errstream, *result, is_bitmask_enum<E>());
+		}
+		return false;
+	}
+
+	if constexpr (is_enum_bitset<E>::value)
+	{
+		out |= value;
+	}
+	else if constexpr (is_bitmask_enum<E>())
+	{
+		out = enum_or(out, value);
+	}
+	else
+	{
+		out = value;
+	}
+	return true;
+}
+
 // pair / tuple / array
 template <class T, class Stream, std::size_t... Is>
-auto parse_tuple_like_impl(T& out, const int argc, const char* const* argv,
-                           std::optional<std::string_view> current_value, int& current_index,
-                           std::index_sequence<Is...>, Stream errstream) -> bool
+constexpr auto parse_tuple_like_impl(T& out, const int argc, const char* const* argv,
+                                     std::optional<std::string_view> current_value,
+                                     int& current_index, std::index_sequence<Is...>,
+                                     Stream errstream) -> bool
 {
 	constexpr auto n_elements = sizeof...(Is);
 	static_assert(n_elements > 0, "Requires non-empty pair/tuple");
@@ -132,27 +211,27 @@ auto parse_tuple_like_impl(T& out, const int argc, const char* const* argv,
 }
 
 template <class Stream, class... Ts>
-auto parse_value(std::tuple<Ts...>& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(std::tuple<Ts...>& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	return parse_tuple_like_impl(out, argc, argv, current_value, current_index,
 	                             std::make_index_sequence<sizeof...(Ts)>(), errstream);
 }
 
 template <class T, class U, class Stream>
-auto parse_value(std::pair<T, U>& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(std::pair<T, U>& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	return parse_tuple_like_impl(out, argc, argv, current_value, current_index,
 	                             std::make_index_sequence<2>(), errstream);
 }
 
 template <class T, std::size_t N, class Stream>
-auto parse_value(std::array<T, N>& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(std::array<T, N>& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	static_assert(N > 0, "Requires non-empty array");
 
@@ -172,10 +251,66 @@ auto parse_value(std::array<T, N>& out, const int argc, const char* const* argv,
 	return true;
 }
 
+// Multi-value options (--files a.txt b.txt c.txt). The values are not copied, the result is a view
+// into argv spanning every argument up to the next one that isn't positional. Negative numbers are
+// values if NegativeNumbers, see negative_numbers_are_positional.
+template <bool NegativeNumbers, class Stream>
+constexpr auto parse_argv_run(const int argc, const char* const* argv,
+                              std::optional<std::string_view> current_value, int& current_index,
+                              Stream errstream) -> std::optional<std::span<const char* const>>
+{
+	if (current_value.has_value())
+	{
+		// A joined value is only part of an argv element, so it can't be viewed in place.
+		output(errstream, "Multi-value option does not accept a joined value ({})", *current_value);
+		return {};
+	}
+
+	const int first = current_index;
+	for (; current_index < argc; ++current_index)
+	{
+		const auto kind = classify_token(argv[current_index]);
+		if (kind != token_kind::positional &&
+		    !(NegativeNumbers && kind == token_kind::negative_number))
+		{
+			break;
+		}
+	}
+
+	return std::span{argv + first, static_cast<std::size_t>(current_index - first)};
+}
+
+// Without the struct, negative numbers end the run, see parse_field_value.
+template <class Stream>
+constexpr auto parse_value(std::span<const char* const>& out, const int argc,
+                           const char* const* argv, std::optional<std::string_view> current_value,
+                           int& current_index, Stream errstream) -> bool
+{
+	const auto result = parse_argv_run<false>(argc, argv, current_value, current_index, errstream);
+	if (result)
+	{
+		out = *result;
+	}
+	return result.has_value();
+}
+
 template <class T, class Stream>
-auto parse_value(std::optional<T>& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(values_view<T>& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
+{
+	const auto result = parse_argv_run<false>(argc, argv, current_value, current_index, errstream);
+	if (result)
+	{
+		out = values_view<T>{*result};
+	}
+	return result.has_value();
+}
+
+template <class T, class Stream>
+constexpr auto parse_value(std::optional<T>& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	T result{};
 	const auto parse_result =
@@ -189,9 +324,9 @@ auto parse_value(std::optional<T>& out, const int argc, const char* const* argv,
 }
 
 template <set_like T, class Stream>
-auto parse_value(T& out, const int argc, const char* const* argv,
-                 std::optional<std::string_view> current_value, int& current_index,
-                 Stream errstream) -> bool
+constexpr auto parse_value(T& out, const int argc, const char* const* argv,
+                           std::optional<std::string_view> current_value, int& current_index,
+                           Stream errstream) -> bool
 {
 	typename T::value_type to_insert;
 	const auto parse_result =
@@ -205,41 +340,133 @@ auto parse_value(T& out, const int argc, const char* const* argv,
 }
 
 template <class Stream>
-auto parse_value(bool& out, [[maybe_unused]] const int argc,
-                 [[maybe_unused]] const char* const* argv,
-                 [[maybe_unused]] std::optional<std::string_view> current_value,
-                 [[maybe_unused]] int& current_index, [[maybe_unused]] Stream errstream) -> bool
+constexpr auto parse_value(bool& out, [[maybe_unused]] const int argc,
+                           [[maybe_unused]] const char* const* argv,
+                           [[maybe_unused]] std::optional<std::string_view> current_value,
+                           [[maybe_unused]] int& current_index,
+                           [[maybe_unused]] Stream errstream) -> bool
 {
 	out = !out;
 	return true;
 }
 
+// Subcommands. The command name is the current argument, and everything after it belongs to the
+// command.
+template <class Stream, class... Ts>
+constexpr auto parse_value(std::variant<Ts...>& out, const int argc, const char* const* argv,
+                           [[maybe_unused]] std::optional<std::string_view> current_value,
+                           int& current_index, Stream errstream) -> bool
+{
+	// Subcommands are always positional
+	assert(!current_value.has_value() && current_index < argc);
+
+	const int command_index = current_index;
+	current_index = argc;
+	return parse_subcommand(out, argc - command_index, argv + command_index, errstream);
+}
+
 template <class T, std::size_t N>
 consteval auto is_single_use_arg() -> bool
 {
-	using M =
-		typename pointer_to_member<decltype(std::get<N>(meta<T>::value.args_).memptr)>::member;
-	return !set_like<M>;
+	using M = member_type_of<T, N>;
+	return (!set_like<M> && !enum_flags<M>) ||
+	       std::get<N>(meta<T>::value.args_).options.bit != no_bit;
 }
 
+// One bit per (flat) argument of T, tracking which have been given.
+template <class T>
+using used_args_t = bitmask<n_flat_args<T>()>;
+
+// Flips a single bit flag, see opt::bit.
+template <std::size_t Bit, class M>
+constexpr auto flip_bit(M& out) -> void
+{
+	static_assert(is_bit_storage<M>::value, "Bit flags must be stored in a std::bitset or an "
+	                                        "unsigned integer");
+	if constexpr (std::is_unsigned_v<M>)
+	{
+		static_assert(Bit < sizeof(M) * 8, "Flag bit out of range");
+		out = static_cast<M>(out ^ (M{1} << Bit));
+	}
+	else
+	{
+		static_assert(Bit < M{}.size(), "Flag bit out of range");
+		out.flip(Bit);
+	}
+}
+
+// Records that the Ith (flat) argument of T was given. Fails if it was already given, unless it
+// can be repeated.
 template <class T, std::size_t I, class Stream>
-auto parse_value_into_struct(T& out, const int argc, const char* const* argv,
-                             std::optional<std::string_view> current_value, int& current_index,
-                             bool& used, Stream errstream) -> bool
+constexpr auto mark_used(used_args_t<T>& used, Stream errstream) -> bool
 {
-	constexpr auto memptr = std::get<I>(meta<T>::value.args_).memptr;
+	using field = flat_arg<T, I>;
 
-	if constexpr (is_single_use_arg<T, I>())
+	if constexpr (is_single_use_arg<typename field::owner, field::index>())
 	{
-		if (used)
+		if (used.test(I))
 		{
 			output(errstream, "Duplicate keyword");
 			return false;
 		}
-		used = true;
 	}
+	used.set(I);
+	return true;
+}
+
+// Defined in tokens.hpp, since it needs the keyword names of T.
+template <class T>
+consteval auto negative_numbers_are_positional() -> bool;
+
+// parse_value for a field of T. Multi-value args stop where the main loop of T would read a
+// keyword, so negative numbers are values when they are positional args of T.
+template <class T, class M, class Stream>
+constexpr auto parse_field_value(M& out, const int argc, const char* const* argv,
+                                 std::optional<std::string_view> current_value,
+                                 int& current_index, Stream errstream) -> bool
+{
+	if constexpr (is_argv_view<M>::value)
+	{
+		const auto result = parse_argv_run<negative_numbers_are_positional<T>()>(
+			argc, argv, current_value, current_index, errstream);
+		if (result)
+		{
+			out = M{*result};
+		}
+		return result.has_value();
+	}
+	else
+	{
+		return parse_value(out, argc, argv, current_value, current_index, errstream);
+	}
+}
+
+// I is the flat index of the argument, see flat_arg.
+template <class T, std::size_t I, class Stream>
+constexpr auto parse_value_into_struct(T& out, const int argc, const char* const* argv,
+                                       std::optional<std::string_view> current_value,
+                                       int& current_index, used_args_t<T>& used,
+                                       Stream errstream) -> bool
+{
+	using field = flat_arg<T, I>;
+	constexpr auto info = std::get<field::index>(meta<typename field::owner>::value.args_);
+	constexpr auto memptr = info.memptr;
 
-	return parse_value(out.*memptr, argc, argv, current_value, current_index, errstream);
+	if (!mark_used<T, I>(used, errstream))
+	{
+		return false;
+	}
+
+	if constexpr (info.options.bit != no_bit)
+	{
+		flip_bit<info.options.bit>(field::get(out).*memptr);
+		return true;
+	}
+	else
+	{
+		return parse_field_value<T>(field::get(out).*memptr, argc, argv, current_value,
+		                            current_index, errstream);
+	}
 }
 
 } // namespace cli151::detail
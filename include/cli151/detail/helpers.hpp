@@ -2,6 +2,7 @@
 
 #include <cli151/common.hpp>
 #include <cli151/detail/concepts.hpp>
+#include <cli151/detail/fields.hpp>
 #include <cli151/detail/handlers.hpp>
 #include <cli151/detail/reflect.hpp>
 
@@ -11,6 +12,7 @@
 #include <algorithm>
 #include <array>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <tuple> // IWYU pragma: keep (std::get<std::tuple>)
 #include <utility>
@@ -53,22 +55,53 @@ struct kebabbed_name
 	constexpr static auto name = info.options.arg_name == default_
 	                                 ? detail::kebab<arg_name.size(), &arg_name_data>()
 	                                 : info.options.arg_name;
-	// Use the first letter of the full name, unless explicitly given
-	constexpr static auto abbr =
-		info.options.abbr == default_ ? name.substr(0, 1) : info.options.abbr;
+	// Use the first letter of the full name, unless explicitly given. Prefix families are given
+	// by their prefix instead.
+	constexpr static auto abbr = info.options.abbr != default_ ? info.options.abbr
+	                             : info.options.prefix.empty() ? name.substr(0, 1)
+	                                                           : none;
 };
 
 // Computes the arg_type of the Nth field of T - evaluating guesses when necessary.
 template <class T, std::size_t N>
 consteval auto type_of_arg() -> arg_type
 {
-	// For the first draft, ignore user input. Just guess. (TODO)
+	using type = member_type_of<T, N>;
 
-	using type =
-		typename pointer_to_member<decltype(std::get<N>(meta<T>::value.args_).memptr)>::member;
+	constexpr auto given_type = std::get<N>(meta<T>::value.args_).options.type;
 
-	// If this is an optional, bool, or a set, it's a keyword.
-	if constexpr (is_optional<type>::value || std::is_same_v<bool, type> || set_like<type>)
+	// For the first draft, only trailing args are taken from user input. Just guess the rest.
+	// (TODO)
+	if constexpr (given_type == arg_type::trailing)
+	{
+		static_assert(N + 1 == meta<T>::value.n_args, "Trailing args must be the last argument");
+		static_assert(is_argv_view<type>::value,
+		              "Trailing args must be a std::span<const char* const> or values_view");
+		return arg_type::trailing;
+	}
+	// Option groups are expanded in place, and are skipped over when guessing.
+	else if constexpr (option_group<type>)
+	{
+		if constexpr (N == 0)
+		{
+			return arg_type::positional_required;
+		}
+		else
+		{
+			return type_of_arg<T, N - 1>();
+		}
+	}
+	// Subcommands are positional, and take the rest of the args.
+	else if constexpr (is_variant<type>::value)
+	{
+		static_assert(N + 1 == meta<T>::value.n_args, "Subcommands must be the last argument");
+		return arg_type::positional_required;
+	}
+	// If this is an optional, bool, bit flag, set, set of enum flags, or multi-value view, it's a
+	// keyword.
+	else if constexpr (is_optional<type>::value || std::is_same_v<bool, type> ||
+	                   std::get<N>(meta<T>::value.args_).options.bit != no_bit ||
+	                   set_like<type> || enum_flags<type> || is_argv_view<type>::value)
 	{
 		return arg_type::keyword;
 	}
@@ -90,18 +123,69 @@ struct help_data
 	std::string_view abbr;
 	std::string_view help;
 	arg_type type;
+	bool required;
+	std::string_view exclusive_group;
+	std::string_view depends_on;
+	std::string_view prefix;
+	std::string_view aliases;
+};
+
+// opt::aliases, read one at a time.
+struct alias_reader
+{
+	std::string_view rest;
+
+	// The next alias, with its dashes, or empty at the end.
+	constexpr auto next() -> std::string_view
+	{
+		const auto start = rest.find_first_not_of(' ');
+		if (start == std::string_view::npos)
+		{
+			return {};
+		}
+		rest.remove_prefix(start);
+		const auto alias = rest.substr(0, rest.find(' '));
+		rest.remove_prefix(alias.size());
+		return alias;
+	}
 };
 
+consteval auto aliases_are_valid(std::string_view aliases) -> bool
+{
+	alias_reader reader{aliases};
+	for (auto alias = reader.next(); !alias.empty(); alias = reader.next())
+	{
+		const std::size_t dashes = alias.starts_with("--") ? 2 : 1;
+		if (!alias.starts_with('-') || alias.size() == dashes)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 template <class T, std::size_t I>
 consteval auto make_help_data() -> help_data
 {
 	constexpr opt data = std::get<I>(meta<T>::value.args_).options;
+	constexpr auto type = type_of_arg<T, I>();
+	static_assert(data.prefix.empty() || type == arg_type::keyword,
+	              "Prefix families must be keyword arguments");
+	static_assert(data.aliases.empty() || type == arg_type::keyword,
+	              "Only keyword arguments can have aliases");
+	static_assert(aliases_are_valid(data.aliases),
+	              "Aliases must be space separated, and start with - (short) or -- (long)");
 
 	return {
 		.name = kebabbed_name<T, I>::name,
 		.abbr = kebabbed_name<T, I>::abbr,
 		.help = data.help,
-		.type = type_of_arg<T, I>(),
+		.type = type,
+		.required = type == arg_type::positional_required || data.required,
+		.exclusive_group = data.exclusive_group,
+		.depends_on = data.depends_on,
+		.prefix = data.prefix,
+		.aliases = data.aliases,
 	};
 }
 
@@ -113,80 +197,380 @@ template <class T, std::size_t... Is>
 struct help_data_of_impl<T, std::index_sequence<Is...>>
 {
 	constexpr static std::array data{
-		make_help_data<T, Is>()...,
+		make_help_data<typename flat_arg<T, Is>::owner, flat_arg<T, Is>::index>()...,
 	};
 };
 
+// Help data of every argument of T, with option groups expanded in place.
 template <class T>
-using help_data_of = help_data_of_impl<T, std::make_index_sequence<meta<T>::value.n_args>>;
+using help_data_of = help_data_of_impl<T, std::make_index_sequence<n_flat_args<T>()>>;
 
-// Workaround since frozen::string isn't default constructible.
-// The data in the array is arbitrary and will be overwritten.
-template <std::size_t... Is>
-consteval auto default_name_to_index_map_data(std::index_sequence<Is...>)
+// Whether long keywords of T match regardless of case and of '_' vs '-' (--Num_Threads for
+// --num-threads), set by constexpr static bool loose_keywords in meta<T>. Short keywords are
+// always exact, since -v and -V are commonly different options.
+template <class T>
+consteval auto has_loose_keywords() -> bool
 {
-	return std::array<std::pair<frozen::string, std::size_t>, sizeof...(Is)>{
-		std::pair{frozen::string{""}, Is}...,
+	if constexpr (requires { meta<T>::loose_keywords; })
+	{
+		return meta<T>::loose_keywords;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+constexpr auto fold_keyword_char(char c) -> char
+{
+	if (c >= 'A' && c <= 'Z')
+	{
+		return static_cast<char>(c - 'A' + 'a');
+	}
+	return c == '_' ? '-' : c;
+}
+
+// Hash and equality of loose keywords, folding each char as it's read, so the key is never
+// copied. The hash is the same FNV-1a variant as frozen's default.
+struct folded_hash
+{
+	template <class S>
+	constexpr auto operator()(const S& value, std::size_t seed) const -> std::size_t
+	{
+		std::size_t hash = (0x811c9dc5 ^ seed) * static_cast<std::size_t>(0x01000193);
+		for (std::size_t i = 0; i < value.size(); ++i)
+		{
+			hash = (hash ^ static_cast<unsigned char>(fold_keyword_char(value[i]))) *
+			       static_cast<std::size_t>(0x01000193);
+		}
+		return hash >> 8;
+	}
+};
+
+struct folded_equal
+{
+	template <class A, class B>
+	constexpr auto operator()(const A& a, const B& b) const -> bool
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < a.size(); ++i)
+		{
+			if (fold_keyword_char(a[i]) != fold_keyword_char(b[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+struct keyword_key
+{
+	// Without dashes
+	std::string_view name;
+	// Flat index of the argument
+	std::size_t index;
+};
+
+// The long (if Long) or short names of the keyword arguments of T, including aliases. Loose long
+// names are folded ahead of time, into storage of their own.
+template <class T, bool Long>
+struct keyword_keys
+{
+  private:
+	constexpr static auto help_data = help_data_of<T>::data;
+	constexpr static bool folded = Long && has_loose_keywords<T>();
+
+	constexpr static auto for_each_key = [](auto f)
+	{
+		for (std::size_t i = 0; i < help_data.size(); ++i)
+		{
+			const auto& info = help_data[i];
+			if (info.type != arg_type::keyword)
+			{
+				continue;
+			}
+			if (const auto name = Long ? info.name : info.abbr; !name.empty())
+			{
+				f(name, i);
+			}
+			alias_reader reader{info.aliases};
+			for (auto alias = reader.next(); !alias.empty(); alias = reader.next())
+			{
+				if (alias.starts_with("--") == Long)
+				{
+					f(alias.substr(Long ? 2 : 1), i);
+				}
+			}
+		}
+	};
+
+	constexpr static auto size = []
+	{
+		std::size_t result = 0;
+		for_each_key([&](std::string_view, std::size_t) { ++result; });
+		return result;
+	}();
+
+	constexpr static auto folded_size = []
+	{
+		std::size_t result = 0;
+		if constexpr (folded)
+		{
+			for_each_key([&](std::string_view name, std::size_t) { result += name.size(); });
+		}
+		return result;
+	}();
+
+	constexpr static auto folded_storage = []
+	{
+		std::array<char, folded_size> result{};
+		if constexpr (folded)
+		{
+			auto out = result.begin();
+			for_each_key(
+				[&](std::string_view name, std::size_t)
+				{ out = std::transform(name.begin(), name.end(), out, fold_keyword_char); });
+		}
+		return result;
+	}();
+
+  public:
+	constexpr static auto keys = []
+	{
+		std::array<keyword_key, size> result{};
+		std::size_t index = 0;
+		std::size_t pos = 0;
+		for_each_key(
+			[&](std::string_view name, std::size_t i)
+			{
+				if constexpr (folded)
+				{
+					name = {folded_storage.data() + pos, name.size()};
+					pos += name.size();
+				}
+				result[index++] = {name, i};
+			});
+		return result;
+	}();
+};
+
+// Whether two keyword arguments share a long name, or if abbr is set, a short name, including
+// aliases. Since option groups are expanded into the same maps, this catches collisions between
+// groups.
+template <class T>
+consteval auto has_keyword_name_collision(bool abbr) -> bool
+{
+	const auto has_duplicate = [](const auto& keys)
+	{
+		for (std::size_t i = 0; i < keys.size(); ++i)
+		{
+			for (std::size_t j = i + 1; j < keys.size(); ++j)
+			{
+				if (keys[i].name == keys[j].name)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
 	};
+	return abbr ? has_duplicate(keyword_keys<T, false>::keys)
+	            : has_duplicate(keyword_keys<T, true>::keys);
 }
 
+// Intentionally not constexpr, see constraints_of::index_of
+inline auto depends_on_names_an_unknown_argument() -> void {}
+
+// Masks of the arguments of T which are subject to each kind of constraint, checked all at once
+// against the used args after parsing.
 template <class T>
-consteval auto make_long_name_to_index_map_data()
+struct constraints_of
 {
-	constexpr auto should_include = [](const help_data& info)
-	{ return !info.name.empty() && info.type == arg_type::keyword; };
+  private:
+	constexpr static auto help_data = help_data_of<T>::data;
 
-	constexpr auto help_data = help_data_of<T>::data;
-	constexpr auto size = std::count_if(help_data.begin(), help_data.end(), should_include);
+	constexpr static auto n_exclusive_groups = []
+	{
+		std::size_t result = 0;
+		for (std::size_t i = 0; i < help_data.size(); ++i)
+		{
+			const auto group = help_data[i].exclusive_group;
+			// Count each group at its first appearance
+			result += !group.empty() &&
+			          std::none_of(help_data.begin(), help_data.begin() + i,
+			                       [&](const auto& info) { return info.exclusive_group == group; });
+		}
+		return result;
+	}();
 
-	// Temp hack: Seems to be some issues with 0-length data.
-	if constexpr (size == 0)
+	constexpr static auto n_dependency_targets = []
 	{
-		return std::array<std::pair<frozen::string, std::size_t>, 1>{
-			std::pair{frozen::string{""}, 0},
-		};
+		std::size_t result = 0;
+		for (std::size_t i = 0; i < help_data.size(); ++i)
+		{
+			const auto target = help_data[i].depends_on;
+			result += !target.empty() &&
+			          std::none_of(help_data.begin(), help_data.begin() + i,
+			                       [&](const auto& info) { return info.depends_on == target; });
+		}
+		return result;
+	}();
+
+	constexpr static auto index_of(std::string_view name) -> std::size_t
+	{
+		const auto it = std::find_if(help_data.begin(), help_data.end(),
+		                             [&](const auto& info) { return info.name == name; });
+		if (it == help_data.end())
+		{
+			// Not a constant expression, so this is a compile error.
+			depends_on_names_an_unknown_argument();
+		}
+		return static_cast<std::size_t>(it - help_data.begin());
 	}
-	else
+
+  public:
+	using mask = used_args_t<T>;
+
+	constexpr static mask required = []
 	{
-		auto data = default_name_to_index_map_data(std::make_index_sequence<size>());
+		mask result;
+		for (std::size_t i = 0; i < help_data.size(); ++i)
+		{
+			if (help_data[i].required)
+			{
+				result.set(i);
+			}
+		}
+		return result;
+	}();
 
-		std::size_t index = 0;
+	// Each mask contains all the arguments of a group, at most one may be used.
+	constexpr static auto exclusive_groups = []
+	{
+		std::array<mask, n_exclusive_groups> result{};
+		std::array<std::string_view, n_exclusive_groups> names{};
+		std::size_t n_found = 0;
+		for (std::size_t i = 0; i < help_data.size(); ++i)
+		{
+			const auto group = help_data[i].exclusive_group;
+			if (group.empty())
+			{
+				continue;
+			}
+			const auto pos = static_cast<std::size_t>(
+				std::find(names.begin(), names.begin() + n_found, group) - names.begin());
+			if (pos == n_found)
+			{
+				names[n_found++] = group;
+			}
+			result[pos].set(i);
+		}
+		return result;
+	}();
 
+	struct dependency
+	{
+		// The arguments which need the target
+		mask dependents;
+		std::size_t target;
+	};
+
+	constexpr static auto dependencies = []
+	{
+		std::array<dependency, n_dependency_targets> result{};
+		std::size_t n_found = 0;
 		for (std::size_t i = 0; i < help_data.size(); ++i)
 		{
-			if (should_include(help_data[i]))
+			const auto target_name = help_data[i].depends_on;
+			if (target_name.empty())
+			{
+				continue;
+			}
+			const auto target = index_of(target_name);
+			auto pos = std::size_t{0};
+			while (pos < n_found && result[pos].target != target)
+			{
+				++pos;
+			}
+			if (pos == n_found)
 			{
-				data[index].first = help_data[i].name;
-				data[index].second = i;
-				++index;
+				result[n_found++].target = target;
 			}
+			result[pos].dependents.set(i);
 		}
+		return result;
+	}();
+};
 
-#ifndef NDEBUG
-		assert(index == size);
-		for ([[maybe_unused]] const auto& [name, i] : data)
+// Checks the required, mutually exclusive, and dependent arguments of T. Each check is a few word
+// operations on the used args, and the loops are over the (usually few) groups, not the args.
+template <class T, class Stream>
+constexpr auto check_constraints(const used_args_t<T>& used, Stream errstream) -> bool
+{
+	using constraints = constraints_of<T>;
+	constexpr auto help_data = help_data_of<T>::data;
+
+	if (const auto missing = constraints::required & ~used; missing.any())
+	{
+		const auto& info = help_data[missing.first()];
+		if (info.type == arg_type::positional_required)
 		{
-			assert(name.size() > 0);
-			assert(name != default_);
-			assert(i < meta<T>::value.n_args);
+			output(errstream, "Not enough positional args, missing {}", info.name);
 		}
-#endif
+		else
+		{
+			output(errstream, "Missing required argument --{}", info.name);
+		}
+		return false;
+	}
 
-		return data;
+	for (const auto& group : constraints::exclusive_groups)
+	{
+		const auto given = used & group;
+		if (given.count() > 1)
+		{
+			auto rest = given;
+			rest.reset(given.first());
+			output(errstream, "--{} conflicts with --{}", help_data[rest.first()].name,
+			       help_data[given.first()].name);
+			return false;
+		}
 	}
+
+	for (const auto& [dependents, target] : constraints::dependencies)
+	{
+		if (!used.test(target) && (used & dependents).any())
+		{
+			output(errstream, "--{} requires --{}", help_data[(used & dependents).first()].name,
+			       help_data[target].name);
+			return false;
+		}
+	}
+
+	return true;
 }
 
-template <class T>
-consteval auto make_short_name_to_index_map_data()
+// Workaround since frozen::string isn't default constructible.
+// The data in the array is arbitrary and will be overwritten.
+template <std::size_t... Is>
+consteval auto default_name_to_index_map_data(std::index_sequence<Is...>)
 {
-	constexpr auto should_include = [](const help_data& info)
-	{ return !info.abbr.empty() && info.type == arg_type::keyword; };
+	return std::array<std::pair<frozen::string, std::size_t>, sizeof...(Is)>{
+		std::pair{frozen::string{""}, Is}...,
+	};
+}
 
-	constexpr auto help_data = help_data_of<T>::data;
-	constexpr auto size = std::count_if(help_data.begin(), help_data.end(), should_include);
+template <class T, bool Long>
+consteval auto make_name_to_index_map_data()
+{
+	constexpr auto& keys = keyword_keys<T, Long>::keys;
 
 	// Temp hack: Seems to be some issues with 0-length data.
-	if constexpr (size == 0)
+	if constexpr (keys.size() == 0)
 	{
 		return std::array<std::pair<frozen::string, std::size_t>, 1>{
 			std::pair{frozen::string{""}, 0},
@@ -194,27 +578,20 @@ consteval auto make_short_name_to_index_map_data()
 	}
 	else
 	{
-		auto data = default_name_to_index_map_data(std::make_index_sequence<size>());
+		auto data = default_name_to_index_map_data(std::make_index_sequence<keys.size()>());
 
-		std::size_t index = 0;
-
-		for (std::size_t i = 0; i < help_data.size(); ++i)
+		for (std::size_t i = 0; i < keys.size(); ++i)
 		{
-			if (should_include(help_data[i]))
-			{
-				data[index].first = help_data[i].abbr;
-				data[index].second = i;
-				++index;
-			}
+			data[i].first = keys[i].name;
+			data[i].second = keys[i].index;
 		}
 
 #ifndef NDEBUG
-		assert(index == size);
 		for ([[maybe_unused]] const auto& [name, i] : data)
 		{
 			assert(name.size() > 0);
 			assert(name != default_);
-			assert(i < meta<T>::value.n_args);
+			assert(i < n_flat_args<T>());
 		}
 #endif
 
@@ -222,6 +599,20 @@ consteval auto make_short_name_to_index_map_data()
 	}
 }
 
+template <class T>
+consteval auto make_long_name_to_index_map()
+{
+	if constexpr (has_loose_keywords<T>())
+	{
+		return frozen::make_unordered_map(make_name_to_index_map_data<T, true>(), folded_hash{},
+		                                  folded_equal{});
+	}
+	else
+	{
+		return frozen::make_unordered_map(make_name_to_index_map_data<T, true>());
+	}
+}
+
 template <class T>
 consteval auto make_positional_args_indexes_data()
 {
@@ -247,16 +638,42 @@ consteval auto make_positional_args_indexes_data()
 	assert(index == size);
 	for ([[maybe_unused]] const auto i : data)
 	{
-		assert(i < meta<T>::value.n_args);
+		assert(i < n_flat_args<T>());
 	}
 #endif
 
 	return data;
 }
 
+// Index of the trailing argument of T, or n_args if there is none.
+template <class T>
+consteval auto trailing_arg_index() -> std::size_t
+{
+	constexpr auto help_data = help_data_of<T>::data;
+	const auto it = std::find_if(help_data.begin(), help_data.end(), [](const auto& info)
+	                             { return info.type == arg_type::trailing; });
+	return static_cast<std::size_t>(it - help_data.begin());
+}
+
+// Stores the remainder of argv into the trailing argument of T. Does nothing if there is none, in
+// which case it is never called.
+template <class T>
+constexpr void set_trailing_args([[maybe_unused]] T& out,
+                                 [[maybe_unused]] std::span<const char* const> rest)
+{
+	if constexpr (trailing_arg_index<T>() < n_flat_args<T>())
+	{
+		using field = flat_arg<T, trailing_arg_index<T>()>;
+		constexpr auto memptr =
+			std::get<field::index>(meta<typename field::owner>::value.args_).memptr;
+		using M = std::remove_cvref_t<decltype(field::get(out).*memptr)>;
+		field::get(out).*memptr = M{rest};
+	}
+}
+
 template <class T, class Out>
 using handler_t = auto (*)(T&, int, const char* const*, std::optional<std::string_view>, int&,
-                           bool&, Out) -> bool;
+                           used_args_t<T>&, Out) -> bool;
 
 template <class T, class Stream, class Seq>
 struct handler_dispatcher_impl
@@ -265,15 +682,21 @@ struct handler_dispatcher_impl
 template <class T, class Stream, std::size_t... Is>
 struct handler_dispatcher_impl<T, Stream, std::index_sequence<Is...>>
 {
+	static_assert(!has_keyword_name_collision<T>(false),
+	              "Two keyword arguments have the same name, possibly from different option "
+	              "groups");
+	static_assert(!has_keyword_name_collision<T>(true),
+	              "Two keyword arguments have the same abbreviation, possibly from different "
+	              "option groups. Use abbr to change or remove one of them");
+
 	// This is only a map from the long name. We need the short names too, and we need to omit
 	// ones which are not specified. Maybe a helper that computes the data? Counting the number
 	// of names is cheap.
 
 	// Maps long and short names of keyword arguments to the index in index_to_handler_map.
-	constexpr static auto long_name_to_index_map =
-		frozen::make_unordered_map(make_long_name_to_index_map_data<T>());
+	constexpr static auto long_name_to_index_map = make_long_name_to_index_map<T>();
 	constexpr static auto short_name_to_index_map =
-		frozen::make_unordered_map(make_short_name_to_index_map_data<T>());
+		frozen::make_unordered_map(make_name_to_index_map_data<T, false>());
 
 	constexpr static std::array<handler_t<T, Stream>, sizeof...(Is)> index_to_handler_map{
 		parse_value_into_struct<T, Is>...,
@@ -286,66 +709,42 @@ struct handler_dispatcher_impl<T, Stream, std::index_sequence<Is...>>
 	// can skip the array conditionally (likely easy), or we can rearrange the args (likely
 	// difficult).
 	constexpr static auto positional_args_indexes = make_positional_args_indexes_data<T>();
+
+	constexpr static auto trailing_arg_index = detail::trailing_arg_index<T>();
+	constexpr static bool has_trailing_args = trailing_arg_index < sizeof...(Is);
 };
 
 template <class T, class Stream>
 using handler_dispatcher =
-	handler_dispatcher_impl<T, Stream, std::make_index_sequence<meta<T>::value.n_args>>;
+	handler_dispatcher_impl<T, Stream, std::make_index_sequence<n_flat_args<T>()>>;
 
-template <class T, class Stream>
-auto parse_long_keyword(const std::string_view view, int& arg_index, Stream errstream)
-	-> std::optional<std::pair<std::size_t, std::optional<std::string_view>>>
+struct keyword_match
 {
-	using dispatcher = detail::handler_dispatcher<T, Stream>;
-
-	const auto nodashes = view.substr(2);
+	std::string_view key;
+	// The value, if given in the same arg as the key (--key=value)
+	std::optional<std::string_view> value;
+	// Index in index_to_handler_map, if the key is known
+	std::optional<std::size_t> handler_index;
+};
 
+// Splits a keyword arg (without the leading dashes) into key and value, and looks up the key in
+// one of the keyword maps.
+template <class Map>
+constexpr auto find_keyword(const Map& map, const std::string_view nodashes) -> keyword_match
+{
 	// In case this is a key + value, parse out delimiters
 	const auto delimiter_pos = nodashes.find_first_of(":= ");
 	const auto key = nodashes.substr(0, delimiter_pos);
 
-	const auto handler_index = dispatcher::long_name_to_index_map.find(key);
-
-	if (handler_index == dispatcher::long_name_to_index_map.end())
-	{
-		output(errstream, "Unrecognized keyword argument {}", key);
-		return {};
-	}
-
 	const auto value = delimiter_pos == std::string_view::npos ? std::optional<std::string_view>{}
 	                                                           : nodashes.substr(delimiter_pos + 1);
 
-	++arg_index;
-
-	return std::pair{handler_index->second, value};
-}
-
-template <class T, class Stream>
-auto parse_short_keyword(const std::string_view view, int& arg_index, Stream errstream)
-	-> std::optional<std::pair<std::size_t, std::optional<std::string_view>>>
-{
-	using dispatcher = detail::handler_dispatcher<T, Stream>;
-
-	const auto nodashes = view.substr(1);
-
-	// In case this is a key + value, parse out delimiters
-	const auto delimiter_pos = nodashes.find_first_of(":= ");
-	const auto key = nodashes.substr(0, delimiter_pos);
-
-	const auto handler_index = dispatcher::short_name_to_index_map.find(key);
-
-	if (handler_index == dispatcher::short_name_to_index_map.end())
+	const auto it = map.find(key);
+	if (it == map.end())
 	{
-		output(errstream, "Unrecognized keyword argument {}", key);
-		return {};
+		return {key, value, {}};
 	}
-
-	const auto value = delimiter_pos == std::string_view::npos ? std::optional<std::string_view>{}
-	                                                           : nodashes.substr(delimiter_pos + 1);
-
-	++arg_index;
-
-	return std::pair{handler_index->second, value};
+	return {key, value, it->second};
 }
 
 } // namespace cli151::detail
@@ -1,26 +1,103 @@
 #pragma once
 
-#include <cli151/detail/compat.hpp>
+#include <cli151/common.hpp>
+
+#include <cstddef>
 #include <cstdio>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
 namespace cli151::detail
 {
 
-// Wrapper to unify format_to() and print()
+// An error message, with a {} for each argument. Checked at compile time like a format string, but
+// nothing else is supported, so no formatting library is needed to report errors.
+template <class... Args>
+struct message
+{
+	std::string_view text;
+
+	template <class S>
+		requires std::is_convertible_v<const S&, std::string_view>
+	consteval message(const S& text_) : text{text_}
+	{
+		std::size_t n_placeholders = 0;
+		for (std::size_t i = 0; i < text.size(); ++i)
+		{
+			if (text[i] == '{' || text[i] == '}')
+			{
+				if (text.substr(i, 2) != "{}")
+				{
+					message_only_supports_empty_placeholders();
+				}
+				++n_placeholders;
+				++i;
+			}
+		}
+		if (n_placeholders != sizeof...(Args))
+		{
+			message_placeholders_dont_match_arguments();
+		}
+	}
+
+  private:
+	// Intentionally not constexpr, so that a bad message doesn't compile
+	static auto message_only_supports_empty_placeholders() -> void {}
+	static auto message_placeholders_dont_match_arguments() -> void {}
+};
 
-template <class OutputIt, class... Args>
-	requires(!std::is_same_v<OutputIt, FILE*>)
-OutputIt output(OutputIt out, compat::format_string<Args...> fmt, Args&&... args)
+// Only the args themselves are deduced from a call to output.
+template <class... Args>
+using message_for = message<std::type_identity_t<Args>...>;
+
+// Whether report_error(sink, text) is found (by ADL) for Stream, see sink.
+template <class Stream>
+concept custom_sink = requires(Stream& sink, std::string_view text) { report_error(sink, text); };
+
+// Writes text to an error stream: a FILE*, null_sink, a custom sink, or an output iterator of
+// chars.
+template <class Stream>
+auto write_error(Stream& out, std::string_view text) -> void
 {
-	return compat::format_to(out, fmt, std::forward<Args>(args)...);
+	if constexpr (std::is_same_v<Stream, FILE*>)
+	{
+		std::fwrite(text.data(), 1, text.size(), out);
+	}
+	else if constexpr (std::is_same_v<Stream, null_sink>)
+	{
+	}
+	else if constexpr (custom_sink<Stream>)
+	{
+		report_error(out, text);
+	}
+	else
+	{
+		for (const char c : text)
+		{
+			*out++ = c;
+		}
+	}
 }
 
-template <class... Args>
-FILE* output(FILE* out, compat::format_string<Args...> fmt, Args&&... args)
+// Writes an error message to out, replacing each {} with the next argument.
+// Returns out, advanced for output iterators.
+template <class Stream, class... Args>
+constexpr auto output(Stream out, message_for<Args...> fmt, Args&&... args) -> Stream
 {
-	compat::print(out, fmt, std::forward<Args>(args)...);
+	if constexpr (!std::is_same_v<Stream, null_sink>)
+	{
+		auto text = fmt.text;
+		const auto write_next = [&](const auto& arg)
+		{
+			const auto placeholder = text.find("{}");
+			write_error(out, text.substr(0, placeholder));
+			write_error(out, arg);
+			text.remove_prefix(placeholder + 2);
+		};
+		(write_next(args), ...);
+		write_error(out, text);
+	}
 	return out;
 }
 
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/fields.hpp>
+#include <cli151/values_view.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace cli151
+{
+
+// A parsed T together with the arena its strings were copied into, see parse_owned. Move only,
+// moving doesn't move the arena, so the views in value stay valid.
+template <class T>
+class owned
+{
+  public:
+	owned(T value_, std::unique_ptr<char[]> arena_)
+		: val{std::move(value_)}, arena{std::move(arena_)}
+	{}
+
+	auto value() const -> const T& { return val; }
+	auto operator*() const -> const T& { return val; }
+	auto operator->() const -> const T* { return &val; }
+
+  private:
+	T val;
+	std::unique_ptr<char[]> arena;
+};
+
+} // namespace cli151
+
+namespace cli151::detail
+{
+
+// The storage needed to copy everything a value views. Pointer arrays (for argv runs) come first
+// in the arena, so only they need to be aligned.
+struct arena_size
+{
+	std::size_t pointers = 0;
+	std::size_t chars = 0;
+
+	constexpr auto bytes() const -> std::size_t
+	{
+		// Room to align the pointers, wherever the buffer starts
+		return pointers == 0 ? chars
+		                     : alignof(const char*) - 1 + pointers * sizeof(const char*) + chars;
+	}
+};
+
+// Copies strings and argv runs into a buffer sized by arena_size. Every string is null
+// terminated, so a copied string_view can also be read as a C string.
+class arena_writer
+{
+  public:
+	arena_writer(std::span<char> buffer, const arena_size& size)
+	{
+		void* start = buffer.data();
+		std::size_t space = buffer.size();
+		if (size.pointers > 0)
+		{
+			start = std::align(alignof(const char*), size.pointers * sizeof(const char*), start,
+			                   space);
+			pointers = static_cast<const char**>(start);
+			start = pointers + size.pointers;
+		}
+		chars = static_cast<char*>(start);
+	}
+
+	auto copy(std::string_view str) -> std::string_view
+	{
+		const auto result = chars;
+		chars = std::copy(str.begin(), str.end(), chars);
+		*chars++ = '\0';
+		return {result, str.size()};
+	}
+
+	auto copy(std::span<const char* const> run) -> std::span<const char* const>
+	{
+		const auto result = pointers;
+		for (const auto arg : run)
+		{
+			*pointers++ = copy(std::string_view{arg}).data();
+		}
+		return {result, run.size()};
+	}
+
+  private:
+	const char** pointers = nullptr;
+	char* chars = nullptr;
+};
+
+// Whether values of T can view argv.
+template <class T>
+consteval auto has_views() -> bool
+{
+	if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, const char*> ||
+	              is_argv_view<T>::value)
+	{
+		return true;
+	}
+	else if constexpr (is_optional<T>::value)
+	{
+		return has_views<typename T::value_type>();
+	}
+	else if constexpr (requires { std::tuple_size<T>::value; })
+	{
+		return []<std::size_t... Is>(std::index_sequence<Is...>)
+		{ return (has_views<std::tuple_element_t<Is, T>>() || ...); }(
+			std::make_index_sequence<std::tuple_size_v<T>>());
+	}
+	else if constexpr (set_like<T>)
+	{
+		return has_views<typename T::value_type>();
+	}
+	else
+	{
+		// Subcommands, or numbers, enums, and flags
+		return is_variant<T>::value;
+	}
+}
+
+template <class T>
+auto measure_struct(arena_size& size, const T& value) -> void;
+template <class T>
+auto rebase_struct(arena_writer& writer, T& value) -> void;
+
+/*
+measure(size, value) -> void
+Adds the storage needed to copy what value views to size.
+
+rebase(writer, value) -> void
+Copies what value views into the arena, and points value at the copies.
+
+The overloads mirror each other, and the parse_value overloads in handlers.hpp.
+*/
+
+inline auto measure(arena_size& size, std::string_view value) -> void
+{
+	size.chars += value.size() + 1;
+}
+
+inline auto rebase(arena_writer& writer, std::string_view& value) -> void
+{
+	value = writer.copy(value);
+}
+
+inline auto measure(arena_size& size, const char* value) -> void
+{
+	if (value != nullptr)
+	{
+		measure(size, std::string_view{value});
+	}
+}
+
+inline auto rebase(arena_writer& writer, const char*& value) -> void
+{
+	if (value != nullptr)
+	{
+		value = writer.copy(std::string_view{value}).data();
+	}
+}
+
+inline auto measure(arena_size& size, std::span<const char* const> value) -> void
+{
+	size.pointers += value.size();
+	for (const auto arg : value)
+	{
+		measure(size, arg);
+	}
+}
+
+inline auto rebase(arena_writer& writer, std::span<const char* const>& value) -> void
+{
+	value = writer.copy(value);
+}
+
+template <class T>
+auto measure(arena_size& size, const values_view<T>& value) -> void
+{
+	measure(size, value.raw());
+}
+
+template <class T>
+auto rebase(arena_writer& writer, values_view<T>& value) -> void
+{
+	value = values_view<T>{writer.copy(value.raw())};
+}
+
+template <class T>
+	requires(has_views<T>())
+auto measure(arena_size& size, const std::optional<T>& value) -> void
+{
+	if (value)
+	{
+		measure(size, *value);
+	}
+}
+
+template <class T>
+	requires(has_views<T>())
+auto rebase(arena_writer& writer, std::optional<T>& value) -> void
+{
+	if (value)
+	{
+		rebase(writer, *value);
+	}
+}
+
+// pair / tuple / array
+template <class T>
+	requires(has_views<T>() && requires { std::tuple_size<T>::value; })
+auto measure(arena_size& size, const T& value) -> void
+{
+	std::apply([&](const auto&... elements) { (measure(size, elements), ...); }, value);
+}
+
+template <class T>
+	requires(has_views<T>() && requires { std::tuple_size<T>::value; })
+auto rebase(arena_writer& writer, T& value) -> void
+{
+	std::apply([&](auto&... elements) { (rebase(writer, elements), ...); }, value);
+}
+
+template <set_like T>
+	requires(has_views<T>())
+auto measure(arena_size& size, const T& value) -> void
+{
+	for (const auto& element : value)
+	{
+		measure(size, element);
+	}
+}
+
+// The elements of a set are const, so they are moved into a new set. Where the set has node
+// handles, the nodes themselves are moved, so nothing is allocated.
+template <set_like T>
+	requires(has_views<T>())
+auto rebase(arena_writer& writer, T& value) -> void
+{
+	T result;
+	if constexpr (requires { value.extract(value.begin()); })
+	{
+		while (!value.empty())
+		{
+			auto node = value.extract(value.begin());
+			rebase(writer, node.value());
+			result.insert(std::move(node));
+		}
+	}
+	else
+	{
+		for (auto element : value)
+		{
+			rebase(writer, element);
+			result.insert(std::move(element));
+		}
+	}
+	value = std::move(result);
+}
+
+template <class... Ts>
+auto measure(arena_size& size, const std::variant<Ts...>& value) -> void
+{
+	std::visit([&](const auto& command) { measure_struct(size, command); }, value);
+}
+
+template <class... Ts>
+auto rebase(arena_writer& writer, std::variant<Ts...>& value) -> void
+{
+	std::visit([&](auto& command) { rebase_struct(writer, command); }, value);
+}
+
+// Numbers, enums, and flags, and containers of them, which don't view anything.
+template <class T>
+	requires(!has_views<T>())
+auto measure(arena_size&, const T&) -> void
+{}
+
+template <class T>
+	requires(!has_views<T>())
+auto rebase(arena_writer&, T&) -> void
+{}
+
+// The Ith (flat) argument of value. Bit flags share their storage with other arguments, but never
+// view anything, so nothing is counted twice.
+template <class T, std::size_t I>
+auto measure_arg(arena_size& size, const T& value) -> void
+{
+	using field = flat_arg<T, I>;
+	constexpr auto info = std::get<field::index>(meta<typename field::owner>::value.args_);
+	measure(size, field::get(value).*info.memptr);
+}
+
+template <class T, std::size_t I>
+auto rebase_arg(arena_writer& writer, T& value) -> void
+{
+	using field = flat_arg<T, I>;
+	constexpr auto info = std::get<field::index>(meta<typename field::owner>::value.args_);
+	rebase(writer, field::get(value).*info.memptr);
+}
+
+template <class T>
+auto measure_struct(arena_size& size, const T& value) -> void
+{
+	[&]<std::size_t... Is>(std::index_sequence<Is...>)
+	{ (measure_arg<T, Is>(size, value), ...); }(std::make_index_sequence<n_flat_args<T>()>());
+}
+
+template <class T>
+auto rebase_struct(arena_writer& writer, T& value) -> void
+{
+	[&]<std::size_t... Is>(std::index_sequence<Is...>)
+	{ (rebase_arg<T, Is>(writer, value), ...); }(std::make_index_sequence<n_flat_args<T>()>());
+}
+
+template <class T>
+auto measure_all(const T& value) -> arena_size
+{
+	arena_size size;
+	if constexpr (is_variant<T>::value)
+	{
+		measure(size, value);
+	}
+	else
+	{
+		measure_struct(size, value);
+	}
+	return size;
+}
+
+template <class T>
+auto rebase_all(T& value, std::span<char> buffer, const arena_size& size) -> void
+{
+	arena_writer writer{buffer, size};
+	if constexpr (is_variant<T>::value)
+	{
+		rebase(writer, value);
+	}
+	else
+	{
+		rebase_struct(writer, value);
+	}
+}
+
+} // namespace cli151::detail
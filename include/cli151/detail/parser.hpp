@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/helpers.hpp>
+#include <cli151/detail/output.hpp>
+#include <cli151/detail/prefixes.hpp>
+#include <cli151/detail/subcommands.hpp>
+#include <cli151/detail/suggest.hpp>
+#include <cli151/detail/tokens.hpp>
+#include <cli151/option_registry.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+namespace cli151::detail
+{
+
+// Where args which aren't recognized are copied to, see parse_known.
+struct unknown_args
+{
+	char** out;
+	int count;
+
+	auto push(const char* arg) -> void
+	{
+		// argv is only mutable at the top level, the strings themselves aren't modified.
+		out[count++] = const_cast<char*>(arg);
+	}
+};
+
+// Handles a keyword which is not an argument of T. Without somewhere to pass it through to, this
+// is an error, suggesting the closest long name for a long keyword.
+template <class T, class Stream>
+constexpr auto unrecognized_keyword(const keyword_match& match, bool is_long, const int argc,
+                                    const char* const* argv, int& arg_index, unknown_args* unknown,
+                                    Stream errstream) -> bool
+{
+	if (unknown == nullptr)
+	{
+		output(errstream, "Unrecognized keyword argument {}", match.key);
+		if (is_long)
+		{
+			if (const auto suggestion = suggest_keyword<T>(match.key); !suggestion.empty())
+			{
+				output(errstream, ", did you mean --{}?", suggestion);
+			}
+		}
+		return false;
+	}
+
+	unknown->push(argv[arg_index++]);
+	// We don't know if it takes a value. Assume the next arg is one, unless it looks like a
+	// keyword.
+	if (!match.value && arg_index < argc && argv[arg_index][0] != '-')
+	{
+		unknown->push(argv[arg_index++]);
+	}
+	return true;
+}
+
+// Optional behaviour of parse_args.
+struct parse_options
+{
+	// If given, unrecognized keyword args and extra positional args are copied here rather than
+	// being errors.
+	unknown_args* unknown = nullptr;
+	// If given, set on failure to the index of the arg being parsed (for keywords, the key), or to
+	// argc if the error was only found after reading every arg (such as a missing argument).
+	int* error_index = nullptr;
+	// If given, long keywords which aren't arguments of T are looked up here before being
+	// unrecognized.
+	const option_registry* registry = nullptr;
+};
+
+// The main loop of T, shared by the different ways of parsing. Classifies each arg and hands
+// keyword and positional args to handle(handler_index, value, arg_index, used), which consumes
+// the value(s) and advances arg_index. The rest of argv is given to set_trailing(span) if T has
+// trailing args.
+template <class T, class Stream, class Handle, class SetTrailing>
+constexpr auto parse_args(int argc, const char* const* argv, Stream errstream,
+                          parse_options options, Handle handle, SetTrailing set_trailing) -> bool
+{
+	using dispatcher = handler_dispatcher<T, Stream>;
+
+	used_args_t<T> used;
+
+	// High level overview:
+	// - Figure out if this is positional or keyword
+	// - In either case, get the handler and the value to handle
+	// - Call the handler (which should advance the position to the next arg to look at)
+
+	// Eventual TODO: We can probably compile out some of this code when one or more types of args
+	// are entirely missing, for example where all args are positional_required.
+
+	// Skip over argv[0]
+	int arg_index = 1;
+	std::size_t next_positional_arg_to_parse = 0;
+	// Set after "--", from then on everything is positional.
+	bool keywords_ended = false;
+	token_classifier tokens{argc, argv};
+
+	const auto fail = [&](int index)
+	{
+		if (options.error_index != nullptr)
+		{
+			*options.error_index = index;
+		}
+		return false;
+	};
+
+	const auto handle_keyword = [&](const auto& map, std::string_view nodashes, bool is_long)
+	{
+		auto match = find_keyword(map, nodashes);
+		if (!match.handler_index && is_long)
+		{
+			if (options.registry != nullptr)
+			{
+				if (const auto* option = options.registry->find(match.key))
+				{
+					++arg_index;
+					return parse_registered(*option, match.value, argc, argv, arg_index,
+					                        errstream);
+				}
+			}
+			if constexpr (allows_prefixes<T>())
+			{
+				if (!resolve_prefix<T>(match, errstream))
+				{
+					return false;
+				}
+			}
+		}
+		if constexpr (prefix_families<T>::any)
+		{
+			if (!match.handler_index && !is_long)
+			{
+				// The arg as a whole, since a family's value may contain a delimiter (-DNAME=1)
+				const auto family_match = find_prefix_family<T>(nodashes);
+				if (family_match.handler_index)
+				{
+					match = family_match;
+				}
+			}
+		}
+		if (!match.handler_index)
+		{
+			return unrecognized_keyword<T>(match, is_long, argc, argv, arg_index, options.unknown,
+			                               errstream);
+		}
+		++arg_index;
+		return handle(*match.handler_index, match.value, arg_index, used);
+	};
+
+	while (arg_index < argc)
+	{
+		const int token_index = arg_index;
+
+		auto kind = keywords_ended ? token_kind::positional : tokens[arg_index];
+		if (kind == token_kind::negative_number)
+		{
+			kind = negative_numbers_are_positional<T>() ? token_kind::positional
+			                                            : token_kind::short_keyword;
+		}
+
+		switch (kind)
+		{
+		case token_kind::terminator:
+			keywords_ended = true;
+			// Passed through too, so that whatever parses the unknown args doesn't read the
+			// positionals after it as keywords.
+			if (options.unknown != nullptr)
+			{
+				options.unknown->push(argv[arg_index]);
+			}
+			++arg_index;
+			continue;
+		case token_kind::long_keyword:
+			if (!handle_keyword(dispatcher::long_name_to_index_map, argv[arg_index] + 2, true))
+			{
+				return fail(token_index);
+			}
+			continue;
+		case token_kind::short_keyword:
+			if (!handle_keyword(dispatcher::short_name_to_index_map, argv[arg_index] + 1, false))
+			{
+				return fail(token_index);
+			}
+			continue;
+		case token_kind::positional:
+		case token_kind::negative_number:
+			break;
+		}
+
+		// Positional
+		if (next_positional_arg_to_parse >= dispatcher::positional_args_indexes.size())
+		{
+			if constexpr (dispatcher::has_trailing_args)
+			{
+				// Everything from here on is captured as-is, including anything that looks
+				// like a keyword.
+				set_trailing(std::span<const char* const>{
+					argv + arg_index, static_cast<std::size_t>(argc - arg_index)});
+				used.set(dispatcher::trailing_arg_index);
+				break;
+			}
+			else
+			{
+				if (options.unknown != nullptr)
+				{
+					options.unknown->push(argv[arg_index++]);
+					continue;
+				}
+				output(errstream, "Too many positional args");
+				return fail(token_index);
+			}
+		}
+
+		const auto handler_index =
+			dispatcher::positional_args_indexes[next_positional_arg_to_parse++];
+
+		if (!handle(handler_index, std::optional<std::string_view>{}, arg_index, used))
+		{
+			return fail(token_index);
+		}
+	}
+
+	if (!check_constraints<T>(used, errstream))
+	{
+		return fail(argc);
+	}
+	return true;
+}
+
+// Parses argv into result, which should already be initialized. On failure, result may be
+// partially filled.
+template <class T, class Stream>
+constexpr auto parse_into(T& result, int argc, const char* const* argv, Stream errstream,
+                          parse_options options) -> bool
+{
+	using dispatcher = handler_dispatcher<T, Stream>;
+
+	const auto handle = [&](std::size_t handler_index, std::optional<std::string_view> value,
+	                        int& arg_index, used_args_t<T>& used)
+	{
+		const auto handler = dispatcher::index_to_handler_map[handler_index];
+		return handler(result, argc, argv, value, arg_index, used, errstream);
+	};
+	const auto set_trailing = [&](std::span<const char* const> rest)
+	{ set_trailing_args(result, rest); };
+
+	return parse_args<T>(argc, argv, errstream, options, handle, set_trailing);
+}
+
+template <class T, class Stream>
+constexpr auto parse_into(T& result, int argc, const char* const* argv, Stream errstream) -> bool
+{
+	return parse_into(result, argc, argv, errstream, parse_options{});
+}
+
+// A variant of subcommands on its own, with no args of its own.
+template <class Stream, class... Ts>
+constexpr auto parse_into(std::variant<Ts...>& result, int argc, const char* const* argv,
+                          Stream errstream) -> bool
+{
+	if (argc < 2)
+	{
+		output_missing_subcommand<std::variant<Ts...>>(errstream);
+		return false;
+	}
+	return parse_subcommand(result, argc - 1, argv + 1, errstream);
+}
+
+// Whether T has a shared parser, see CLI151_DECLARE_PARSER.
+template <class T>
+struct has_shared_parser : std::false_type
+{};
+
+// parse<T> with the default error stream, as a function which isn't inline (unlike parse, which is
+// constexpr). A TU which has seen extern template struct shared_parser<T> (from
+// CLI151_DECLARE_PARSER) calls it without instantiating the parser of T, which is instantiated
+// once, by CLI151_DEFINE_PARSER.
+template <class T>
+struct shared_parser
+{
+	static auto parse(int argc, const char* const* argv, FILE* errstream) -> std::optional<T>;
+};
+
+template <class T>
+auto shared_parser<T>::parse(int argc, const char* const* argv, FILE* errstream)
+	-> std::optional<T>
+{
+	T result{};
+	if (!parse_into(result, argc, argv, errstream))
+	{
+		return {};
+	}
+	return result;
+}
+
+} // namespace cli151::detail
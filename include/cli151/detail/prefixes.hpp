@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/helpers.hpp>
+#include <cli151/detail/output.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace cli151::detail
+{
+
+// Whether long keywords of T may be shortened to any unambiguous prefix (--verb for --verbose),
+// set by constexpr static bool allow_prefixes in meta<T>. Off by default.
+template <class T>
+consteval auto allows_prefixes() -> bool
+{
+	if constexpr (requires { meta<T>::allow_prefixes; })
+	{
+		return meta<T>::allow_prefixes;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+struct prefix_entry
+{
+	std::string_view name;
+	// Index in index_to_handler_map
+	std::size_t handler_index;
+	// The length of the shortest prefix of name which no name of another argument starts with.
+	// Longer than name if name is a prefix of such a name, in which case only the exact name
+	// matches.
+	std::size_t unique_length;
+};
+
+constexpr auto common_prefix_length(std::string_view a, std::string_view b) -> std::size_t
+{
+	const auto [it, unused] = std::mismatch(a.begin(), a.end(), b.begin(), b.end());
+	return static_cast<std::size_t>(it - a.begin());
+}
+
+// A char of a long keyword as it's compared, folded if T has loose keywords.
+template <class T>
+constexpr auto prefix_char(char c) -> unsigned char
+{
+	return static_cast<unsigned char>(has_loose_keywords<T>() ? fold_keyword_char(c) : c);
+}
+
+// The long keyword names of T, including aliases (folded if loose), sorted, so that the names
+// starting with a given prefix are adjacent.
+template <class T>
+struct long_name_prefixes
+{
+  private:
+	constexpr static auto& keys = keyword_keys<T, true>::keys;
+
+  public:
+	constexpr static auto entries = []
+	{
+		std::array<prefix_entry, keys.size()> result{};
+		for (std::size_t i = 0; i < keys.size(); ++i)
+		{
+			result[i] = {keys[i].name, keys[i].index, 0};
+		}
+		std::sort(result.begin(), result.end(),
+		          [](const prefix_entry& a, const prefix_entry& b) { return a.name < b.name; });
+
+		// Names of the same argument (its aliases) don't make a prefix ambiguous. Of the other
+		// names, only the closest ones in sorted order on either side can share a longer prefix.
+		for (std::size_t i = 0; i < result.size(); ++i)
+		{
+			std::size_t shared = 0;
+			const auto share_with = [&](const prefix_entry& other)
+			{
+				const bool other_arg = other.handler_index != result[i].handler_index;
+				if (other_arg)
+				{
+					shared = std::max(shared, common_prefix_length(result[i].name, other.name));
+				}
+				return other_arg;
+			};
+			for (std::size_t j = i; j > 0; --j)
+			{
+				if (share_with(result[j - 1]))
+				{
+					break;
+				}
+			}
+			for (std::size_t j = i + 1; j < result.size(); ++j)
+			{
+				if (share_with(result[j]))
+				{
+					break;
+				}
+			}
+			result[i].unique_length = shared + 1;
+		}
+		return result;
+	}();
+};
+
+// Resolves a long keyword which isn't an exact name of T as a prefix of one. On a unique match,
+// sets match.handler_index. Returns false (after reporting the candidates) if the prefix is
+// ambiguous, and true otherwise, including when nothing matches.
+template <class T, class Stream>
+constexpr auto resolve_prefix(keyword_match& match, Stream errstream) -> bool
+{
+	constexpr auto& entries = long_name_prefixes<T>::entries;
+	const auto key = match.key;
+
+	const auto char_less = [](char a, char b) { return prefix_char<T>(a) < prefix_char<T>(b); };
+	const auto char_equal = [](char a, char b) { return prefix_char<T>(a) == prefix_char<T>(b); };
+	const auto starts_with_key = [&](std::string_view name)
+	{
+		return name.size() >= key.size() &&
+		       std::equal(key.begin(), key.end(), name.begin(), char_equal);
+	};
+
+	const auto entry_less = [&](const prefix_entry& entry, std::string_view k)
+	{
+		return std::lexicographical_compare(entry.name.begin(), entry.name.end(), k.begin(),
+		                                    k.end(), char_less);
+	};
+
+	const auto first = std::lower_bound(entries.begin(), entries.end(), key, entry_less);
+	if (key.empty() || first == entries.end() || !starts_with_key(first->name))
+	{
+		return true;
+	}
+	if (key.size() >= first->unique_length)
+	{
+		match.handler_index = first->handler_index;
+		return true;
+	}
+
+	output(errstream, "Ambiguous keyword argument {}, could be", key);
+	for (auto it = first; it != entries.end() && starts_with_key(it->name); ++it)
+	{
+		output(errstream, " --{}", it->name);
+	}
+	return false;
+}
+
+struct family_entry
+{
+	std::string_view prefix;
+	// Index in index_to_handler_map
+	std::size_t handler_index;
+};
+
+// The prefix families of T (see opt::prefix), grouped by their first char, longest first within
+// each group. A lookup only compares the few prefixes starting with the same char as the arg.
+template <class T>
+struct prefix_families
+{
+  private:
+	constexpr static auto should_include = [](const help_data& info)
+	{ return !info.prefix.empty(); };
+
+	constexpr static auto help_data = help_data_of<T>::data;
+	constexpr static auto size = static_cast<std::size_t>(
+		std::count_if(help_data.begin(), help_data.end(), should_include));
+
+	constexpr static auto first_char = [](std::string_view prefix)
+	{ return static_cast<unsigned char>(prefix.front()); };
+
+  public:
+	constexpr static bool any = size > 0;
+
+	constexpr static auto entries = []
+	{
+		std::array<family_entry, size> result{};
+		std::size_t index = 0;
+		for (std::size_t i = 0; i < help_data.size(); ++i)
+		{
+			if (should_include(help_data[i]))
+			{
+				result[index++] = {help_data[i].prefix, i};
+			}
+		}
+		std::sort(result.begin(), result.end(),
+		          [](const family_entry& a, const family_entry& b)
+		          {
+			          if (first_char(a.prefix) != first_char(b.prefix))
+			          {
+				          return first_char(a.prefix) < first_char(b.prefix);
+			          }
+			          return a.prefix.size() > b.prefix.size();
+		          });
+		return result;
+	}();
+
+	static_assert(std::adjacent_find(entries.begin(), entries.end(),
+	                                 [](const family_entry& a, const family_entry& b)
+	                                 { return a.prefix == b.prefix; }) == entries.end(),
+	              "Two prefix families have the same prefix");
+
+	// The entries starting with char c are [offsets[c], offsets[c + 1]).
+	constexpr static auto offsets = []
+	{
+		std::array<std::size_t, 257> result{};
+		for (const auto& entry : entries)
+		{
+			++result[first_char(entry.prefix) + 1u];
+		}
+		for (std::size_t i = 1; i < result.size(); ++i)
+		{
+			result[i] += result[i - 1];
+		}
+		return result;
+	}();
+};
+
+// Matches a single dash arg (without the dash) against the prefix families of T. The key of the
+// result is the prefix, and the value is the rest of the arg, if any.
+template <class T>
+constexpr auto find_prefix_family(std::string_view nodashes) -> keyword_match
+{
+	using families = prefix_families<T>;
+
+	if (!nodashes.empty())
+	{
+		const auto c = static_cast<unsigned char>(nodashes.front());
+		for (auto i = families::offsets[c]; i < families::offsets[c + 1u]; ++i)
+		{
+			const auto& entry = families::entries[i];
+			if (nodashes.starts_with(entry.prefix))
+			{
+				const auto rest = nodashes.substr(entry.prefix.size());
+				return {entry.prefix,
+				        rest.empty() ? std::optional<std::string_view>{} : rest,
+				        entry.handler_index};
+			}
+		}
+	}
+	return {nodashes, {}, {}};
+}
+
+} // namespace cli151::detail
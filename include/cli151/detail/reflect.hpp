@@ -3,6 +3,7 @@
 #include <cli151/detail/concepts.hpp>
 
 #include <string_view>
+#include <type_traits>
 
 namespace cli151::detail2
 {
@@ -35,6 +36,34 @@ template <auto Memptr>
 #endif
 }
 
+enum class enum_name_detector
+{
+	dummy
+};
+
+template <auto Value>
+[[nodiscard]] consteval auto get_enum_function_name() -> std::string_view
+{
+#ifdef __GNUC__
+	return std::string_view{__PRETTY_FUNCTION__};
+#else
+	return std::string_view{__FUNCSIG__};
+#endif
+}
+
+struct type_name_detector
+{};
+
+template <class T>
+[[nodiscard]] consteval auto get_type_function_name() -> std::string_view
+{
+#ifdef __GNUC__
+	return std::string_view{__PRETTY_FUNCTION__};
+#else
+	return std::string_view{__FUNCSIG__};
+#endif
+}
+
 } // namespace cli151::detail2
 
 namespace cli151::detail
@@ -61,4 +90,68 @@ template <auto Ptr>
 	return field_name_raw.substr(begin, last - begin);
 }
 
+// Gives the name of the enumerator with the given value, or an empty string if there is none.
+template <auto Value>
+	requires std::is_enum_v<decltype(Value)>
+[[nodiscard]] consteval auto get_enum_value_name() -> std::string_view
+{
+	// Same idea as above, find where the value is printed within the string
+	constexpr auto detector_name =
+		detail2::get_enum_function_name<detail2::enum_name_detector::dummy>();
+	constexpr auto dummy_begin = detector_name.rfind(std::string_view("dummy"));
+	constexpr auto suffix = detector_name.substr(dummy_begin + std::string_view("dummy").size());
+
+	const auto value_name_raw = detail2::get_enum_function_name<Value>();
+	const auto last = value_name_raw.rfind(suffix);
+
+	// Enumerators are printed as their (possibly qualified) name, everything else is printed as
+	// a number, possibly with a cast in front.
+	auto begin = last;
+	while (begin > 0)
+	{
+		const char c = value_name_raw[begin - 1];
+		if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		      (c >= '0' && c <= '9')))
+		{
+			break;
+		}
+		--begin;
+	}
+
+	const auto name = value_name_raw.substr(begin, last - begin);
+	if (name.empty() || (name[0] >= '0' && name[0] <= '9'))
+	{
+		return {};
+	}
+	return name;
+}
+
+// Gives the unqualified name of a type. Empty for types whose name doesn't end in an identifier,
+// such as template specializations.
+template <class T>
+[[nodiscard]] consteval auto get_type_name() -> std::string_view
+{
+	constexpr auto detector_name = detail2::get_type_function_name<detail2::type_name_detector>();
+	constexpr auto detector_begin = detector_name.rfind(std::string_view("type_name_detector"));
+	constexpr auto suffix =
+		detector_name.substr(detector_begin + std::string_view("type_name_detector").size());
+
+	const auto type_name_raw = detail2::get_type_function_name<T>();
+	const auto last = type_name_raw.rfind(suffix);
+
+	auto begin = last;
+	while (begin > 0)
+	{
+		const char c = type_name_raw[begin - 1];
+		if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		      (c >= '0' && c <= '9')))
+		{
+			break;
+		}
+		--begin;
+	}
+
+	return type_name_raw.substr(begin, last - begin);
+}
+
 } // namespace cli151::detail
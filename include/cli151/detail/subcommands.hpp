@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/helpers.hpp>
+#include <cli151/detail/output.hpp>
+#include <cli151/detail/reflect.hpp>
+
+#include <frozen/string.h>
+#include <frozen/unordered_map.h>
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+namespace cli151::detail
+{
+
+// The name of a subcommand. Either meta<T>::name, or the kebabbed name of T.
+template <class T>
+struct command_name
+{
+  private:
+	constexpr static auto type_name = get_type_name<T>();
+	constexpr static auto type_name_data = type_name.data();
+
+	consteval static auto get() -> std::string_view
+	{
+		if constexpr (requires { meta<T>::name; })
+		{
+			return meta<T>::name;
+		}
+		else
+		{
+			static_assert(!type_name.empty(), "Can't reflect the subcommand name, give it with "
+			                                  "meta<T>::name");
+			return kebab<type_name.size(), &type_name_data>();
+		}
+	}
+
+  public:
+	constexpr static std::string_view value = get();
+};
+
+template <class V, std::size_t I, class Stream>
+constexpr auto parse_subcommand_alternative(V& out, int argc, const char* const* argv,
+                                            Stream errstream) -> bool
+{
+	return parse_into(out.template emplace<I>(), argc, argv, errstream);
+}
+
+template <class V, class Stream>
+using subcommand_parser_t = auto (*)(V&, int, const char* const*, Stream) -> bool;
+
+template <class V>
+consteval auto has_unique_names(const V& names) -> bool
+{
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		for (std::size_t j = i + 1; j < names.size(); ++j)
+		{
+			if (names[i] == names[j])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+template <class V, class Stream, class Seq>
+struct subcommand_dispatcher_impl
+{};
+
+template <class Stream, class... Ts, std::size_t... Is>
+struct subcommand_dispatcher_impl<std::variant<Ts...>, Stream, std::index_sequence<Is...>>
+{
+	using variant = std::variant<Ts...>;
+
+	constexpr static std::array<std::string_view, sizeof...(Ts)> names{
+		command_name<Ts>::value...,
+	};
+	static_assert(has_unique_names(names), "Subcommand names must be unique");
+
+	// Maps the names of the commands to the index in index_to_parser_map, which is also the index
+	// of the alternative.
+	constexpr static auto name_to_index_map = frozen::make_unordered_map(std::array{
+		std::pair{frozen::string{command_name<Ts>::value}, Is}...,
+	});
+
+	constexpr static std::array<subcommand_parser_t<variant, Stream>, sizeof...(Ts)>
+		index_to_parser_map{
+			parse_subcommand_alternative<variant, Is, Stream>...,
+		};
+};
+
+template <class V, class Stream>
+using subcommand_dispatcher =
+	subcommand_dispatcher_impl<V, Stream, std::make_index_sequence<std::variant_size_v<V>>>;
+
+template <class V, class Stream>
+constexpr auto output_missing_subcommand(Stream errstream) -> void
+{
+	output(errstream, "Missing subcommand, expected one of:");
+	for (const auto name : subcommand_dispatcher<V, Stream>::names)
+	{
+		output(errstream, " {}", name);
+	}
+}
+
+// argv[0] is the name of the command, the rest are its args. Only the named command is parsed.
+template <class Stream, class... Ts>
+constexpr auto parse_subcommand(std::variant<Ts...>& out, int argc, const char* const* argv,
+                                Stream errstream) -> bool
+{
+	using dispatcher = subcommand_dispatcher<std::variant<Ts...>, Stream>;
+
+	const std::string_view name = argv[0];
+	const auto it = dispatcher::name_to_index_map.find(name);
+	if (it == dispatcher::name_to_index_map.end())
+	{
+		output(errstream, "Unknown subcommand {}", name);
+		return false;
+	}
+
+	return dispatcher::index_to_parser_map[it->second](out, argc, argv, errstream);
+}
+
+} // namespace cli151::detail
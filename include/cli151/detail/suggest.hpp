@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/helpers.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace cli151::detail
+{
+
+// Bit-parallel Levenshtein distance (Myers 1999, in the form of Hyyrö 2001), against a pattern of
+// at most 64 chars. Each char of the text costs a handful of word operations, regardless of the
+// length of the pattern.
+class edit_pattern
+{
+  public:
+	constexpr static std::size_t max_size = 64;
+
+	// Only the first max_size chars of pattern are used.
+	constexpr explicit edit_pattern(std::string_view pattern)
+		: size{pattern.size() < max_size ? pattern.size() : max_size}
+	{
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			peq[static_cast<unsigned char>(pattern[i])] |= std::uint64_t{1} << i;
+		}
+	}
+
+	constexpr auto distance(std::string_view text) const -> std::size_t
+	{
+		if (size == 0)
+		{
+			return text.size();
+		}
+
+		const std::uint64_t last = std::uint64_t{1} << (size - 1);
+		std::uint64_t pv = ~std::uint64_t{0};
+		std::uint64_t mv = 0;
+		std::size_t score = size;
+
+		for (const char c : text)
+		{
+			const auto eq = peq[static_cast<unsigned char>(c)];
+			const auto xv = eq | mv;
+			const auto xh = (((eq & pv) + pv) ^ pv) | eq;
+			auto ph = mv | ~(xh | pv);
+			auto mh = pv & xh;
+			if (ph & last)
+			{
+				++score;
+			}
+			else if (mh & last)
+			{
+				--score;
+			}
+			// The first row is the distance from the empty pattern, which always grows by one.
+			ph = (ph << 1) | 1;
+			mh <<= 1;
+			pv = mh | ~(xv | ph);
+			mv = ph & xv;
+		}
+		return score;
+	}
+
+  private:
+	std::array<std::uint64_t, 256> peq{};
+	std::size_t size;
+};
+
+// The long keyword name of T (or alias) closest to key, if it's close enough to be a likely typo:
+// at most a third of the key's length, and at most 3 edits. Otherwise empty. With loose keywords,
+// key is folded like the names are.
+template <class T>
+constexpr auto suggest_keyword(std::string_view key) -> std::string_view
+{
+	if (key.empty() || key.size() > edit_pattern::max_size)
+	{
+		return {};
+	}
+
+	std::array<char, edit_pattern::max_size> folded{};
+	if constexpr (has_loose_keywords<T>())
+	{
+		for (std::size_t i = 0; i < key.size(); ++i)
+		{
+			folded[i] = fold_keyword_char(key[i]);
+		}
+		key = {folded.data(), key.size()};
+	}
+
+	const edit_pattern pattern{key};
+	const auto max_distance = key.size() / 3 < 3 ? key.size() / 3 : 3;
+
+	std::string_view best;
+	auto best_distance = max_distance + 1;
+	for (const auto& candidate : keyword_keys<T, true>::keys)
+	{
+		const auto name = candidate.name;
+		// The distance is at least the difference in lengths.
+		const auto length_difference =
+			name.size() > key.size() ? name.size() - key.size() : key.size() - name.size();
+		if (length_difference >= best_distance)
+		{
+			continue;
+		}
+		const auto distance = pattern.distance(name);
+		if (distance < best_distance)
+		{
+			best = name;
+			best_distance = distance;
+		}
+	}
+	return best;
+}
+
+} // namespace cli151::detail
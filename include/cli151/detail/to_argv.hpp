@@ -0,0 +1,406 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/compat.hpp>
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/enums.hpp>
+#include <cli151/detail/fields.hpp>
+#include <cli151/detail/helpers.hpp>
+#include <cli151/enum_bitset.hpp>
+#include <cli151/values_view.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cli151::detail
+{
+
+// Writes null terminated tokens back to back into a single buffer, and pointers to them into an
+// argv style array. Every function returns false if either runs out of space.
+struct argv_writer
+{
+	std::span<char> buffer;
+	std::span<char*> out;
+	// Number of chars of buffer used
+	std::size_t size = 0;
+	int argc = 0;
+	std::size_t token_start = 0;
+
+	auto append(std::string_view str) -> bool
+	{
+		if (str.size() > buffer.size() - size)
+		{
+			return false;
+		}
+		std::copy(str.begin(), str.end(), buffer.data() + size);
+		size += str.size();
+		return true;
+	}
+
+	template <class N>
+	auto append_number(N value) -> bool
+	{
+		char* const first = buffer.data() + size;
+		char* const last = buffer.data() + buffer.size();
+#if CLI151_HAS_FROM_CHARS
+		const auto [ptr, ec] = std::to_chars(first, last, value);
+		if (ec != std::errc())
+		{
+			return false;
+		}
+#else
+		// Without std::to_chars for floating point, format gives the same shortest round trip
+		// representation.
+		std::array<char, 64> temp;
+		const auto temp_end = compat::format_to(temp.data(), "{}", value);
+		if (temp_end - temp.data() > last - first)
+		{
+			return false;
+		}
+		const auto ptr = std::copy(temp.data(), temp_end, first);
+#endif
+		size = static_cast<std::size_t>(ptr - buffer.data());
+		return true;
+	}
+
+	// Ends the current token, which starts right after the previous one. Always leaves room for
+	// the null pointer after the last token.
+	auto end_token() -> bool
+	{
+		if (size == buffer.size() || static_cast<std::size_t>(argc) + 1 >= out.size())
+		{
+			return false;
+		}
+		buffer[size++] = '\0';
+		out[static_cast<std::size_t>(argc++)] = buffer.data() + token_start;
+		token_start = size;
+		return true;
+	}
+
+	auto token(std::string_view str) -> bool { return append(str) && end_token(); }
+};
+
+/*
+write_value(writer, value) -> bool
+Appends the text of a single value to the current token, in a form convert_value reads back.
+*/
+
+inline auto write_value(argv_writer& writer, std::string_view value) -> bool
+{
+	return writer.append(value);
+}
+
+inline auto write_value(argv_writer& writer, const char* value) -> bool
+{
+	return value != nullptr && writer.append(value);
+}
+
+template <class T>
+	requires((std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_floating_point_v<T>)
+auto write_value(argv_writer& writer, T value) -> bool
+{
+	return writer.append_number(value);
+}
+
+template <class E>
+	requires(std::is_enum_v<E> && !is_bitmask_enum<E>())
+auto write_value(argv_writer& writer, E value) -> bool
+{
+	const auto name = enum_info<E>::name_of(value);
+	return !name.empty() && writer.append(name);
+}
+
+// Writes "--name=", the start of every keyword with a value.
+inline auto write_key(argv_writer& writer, std::string_view name) -> bool
+{
+	return writer.append("--") && writer.append(name) && writer.append("=");
+}
+
+/*
+write_keyword_value(writer, name, value) -> bool
+Writes the tokens of a keyword argument with a value, as --name=value.
+*/
+
+template <class T>
+auto write_keyword_value(argv_writer& writer, std::string_view name, const T& value) -> bool
+{
+	return write_key(writer, name) && write_value(writer, value) && writer.end_token();
+}
+
+// pair / tuple / array. The first element is joined to the key, the rest are separate args.
+template <class T>
+	requires requires { std::tuple_size<T>::value; }
+auto write_keyword_value(argv_writer& writer, std::string_view name, const T& value) -> bool
+{
+	const auto write_elements = [&](const auto& first, const auto&... rest)
+	{
+		return write_key(writer, name) && write_value(writer, first) && writer.end_token() &&
+		       ((write_value(writer, rest) && writer.end_token()) && ...);
+	};
+	return std::apply(write_elements, value);
+}
+
+/*
+write_keyword(writer, name, value, default_value) -> bool
+Writes the tokens of a keyword argument, if value differs from default_value (the value of the
+field before parsing). Fails if the value can't be expressed, for example if an accumulating field
+would need bits removed.
+*/
+
+template <class T>
+auto write_keyword(argv_writer& writer, std::string_view name, const T& value,
+                   const T& default_value) -> bool
+{
+	return value == default_value || write_keyword_value(writer, name, value);
+}
+
+inline auto write_keyword(argv_writer& writer, std::string_view name, bool value,
+                          bool default_value) -> bool
+{
+	// Given once, the flag flips
+	return value == default_value || (writer.append("--") && writer.token(name));
+}
+
+template <class T>
+auto write_keyword(argv_writer& writer, std::string_view name, const std::optional<T>& value,
+                   const std::optional<T>& default_value) -> bool
+{
+	return value == default_value ||
+	       (value.has_value() && write_keyword_value(writer, name, *value));
+}
+
+// Multi-value options. Values starting with a dash would be read as keywords.
+inline auto write_argv_run(argv_writer& writer, std::string_view name,
+                           std::span<const char* const> values) -> bool
+{
+	if (values.empty())
+	{
+		return true;
+	}
+	if (!writer.append("--") || !writer.token(name))
+	{
+		return false;
+	}
+	return std::all_of(values.begin(), values.end(), [&](std::string_view value)
+	                   { return !value.starts_with('-') && writer.token(value); });
+}
+
+inline auto write_keyword(argv_writer& writer, std::string_view name,
+                          std::span<const char* const> value, std::span<const char* const>)
+	-> bool
+{
+	return write_argv_run(writer, name, value);
+}
+
+template <class T>
+auto write_keyword(argv_writer& writer, std::string_view name, const values_view<T>& value,
+                   const values_view<T>&) -> bool
+{
+	return write_argv_run(writer, name, value.raw());
+}
+
+// Sets accumulate, so only the elements missing from the default are written.
+template <set_like T>
+auto write_keyword(argv_writer& writer, std::string_view name, const T& value,
+                   const T& default_value) -> bool
+{
+	for (const auto& element : default_value)
+	{
+		if (value.find(element) == value.end())
+		{
+			return false;
+		}
+	}
+	for (const auto& element : value)
+	{
+		if (default_value.find(element) == default_value.end() &&
+		    !write_keyword_value(writer, name, element))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Bitmask enums and enum_bitset, written as a list of the enumerators added to the default.
+template <enum_flags T>
+auto write_keyword(argv_writer& writer, std::string_view name, const T& value,
+                   const T& default_value) -> bool
+{
+	if (value == default_value)
+	{
+		return true;
+	}
+
+	using E = typename flag_enum<T>::type;
+
+	const auto has = [](const T& flags, E enumerator)
+	{
+		if constexpr (is_enum_bitset<T>::value)
+		{
+			return flags.test(enumerator);
+		}
+		else
+		{
+			return enum_or(flags, enumerator) == flags;
+		}
+	};
+
+	// What parsing the written list would give
+	T result = default_value;
+	bool first = true;
+	if (!write_key(writer, name))
+	{
+		return false;
+	}
+	for (std::size_t i = 0; i < enum_info<E>::values.size(); ++i)
+	{
+		const auto enumerator = enum_info<E>::values[i];
+		if (has(value, enumerator) && !has(default_value, enumerator))
+		{
+			if (!(first || writer.append(",")) || !writer.append(enum_info<E>::names[i]))
+			{
+				return false;
+			}
+			first = false;
+			if constexpr (is_enum_bitset<T>::value)
+			{
+				result.set(enumerator);
+			}
+			else
+			{
+				result = enum_or(result, enumerator);
+			}
+		}
+	}
+	return !first && result == value && writer.end_token();
+}
+
+/*
+write_positional(writer, value) -> bool
+Writes the tokens of a positional argument.
+*/
+
+template <class T>
+auto write_positional(argv_writer& writer, const T& value) -> bool
+{
+	if constexpr (requires { std::tuple_size<T>::value; })
+	{
+		return std::apply(
+			[&](const auto&... elements)
+			{ return ((write_value(writer, elements) && writer.end_token()) && ...); },
+			value);
+	}
+	else
+	{
+		return write_value(writer, value) && writer.end_token();
+	}
+}
+
+template <class T, std::size_t I>
+auto write_flat_keyword(argv_writer& writer, const T& value, const T& default_value) -> bool
+{
+	using field = flat_arg<T, I>;
+	constexpr auto info = std::get<field::index>(meta<typename field::owner>::value.args_);
+	constexpr auto help_data = help_data_of<T>::data[I];
+
+	if constexpr (help_data.type != arg_type::keyword)
+	{
+		return true;
+	}
+	else if constexpr (info.options.bit != no_bit)
+	{
+		const auto test = [](const auto& bits)
+		{
+			if constexpr (std::is_unsigned_v<std::remove_cvref_t<decltype(bits)>>)
+			{
+				return ((bits >> info.options.bit) & 1) != 0;
+			}
+			else
+			{
+				return bits.test(info.options.bit);
+			}
+		};
+		return test(field::get(value).*info.memptr) ==
+		           test(field::get(default_value).*info.memptr) ||
+		       (writer.append("--") && writer.token(help_data.name));
+	}
+	else
+	{
+		static_assert(!help_data.name.empty(),
+		              "Keyword args without a long name can't be written by to_argv");
+		return write_keyword(writer, help_data.name, field::get(value).*info.memptr,
+		                     field::get(default_value).*info.memptr);
+	}
+}
+
+template <class T, std::size_t I>
+auto write_flat_positional(argv_writer& writer, const T& value) -> bool
+{
+	using field = flat_arg<T, I>;
+	constexpr auto info = std::get<field::index>(meta<typename field::owner>::value.args_);
+	constexpr auto type = help_data_of<T>::data[I].type;
+
+	if constexpr (type == arg_type::positional_required)
+	{
+		static_assert(!is_variant<member_type_of<typename field::owner, field::index>>::value,
+		              "Subcommands can't be written by to_argv");
+		return write_positional(writer, field::get(value).*info.memptr);
+	}
+	else if constexpr (type == arg_type::trailing)
+	{
+		const auto& rest = field::get(value).*info.memptr;
+		std::span<const char* const> raw;
+		if constexpr (requires { rest.raw(); })
+		{
+			raw = rest.raw();
+		}
+		else
+		{
+			raw = rest;
+		}
+		return std::all_of(raw.begin(), raw.end(),
+		                   [&](std::string_view arg) { return writer.token(arg); });
+	}
+	else
+	{
+		return true;
+	}
+}
+
+template <class T, std::size_t... Is>
+auto write_args(argv_writer& writer, const T& value, std::index_sequence<Is...>) -> bool
+{
+	const T default_value{};
+
+	if (!(write_flat_keyword<T, Is>(writer, value, default_value) && ...))
+	{
+		return false;
+	}
+
+	// Keywords are over, so positional args can't be mistaken for them.
+	constexpr auto help_data = help_data_of<T>::data;
+	constexpr bool has_positional_args =
+		std::any_of(help_data.begin(), help_data.end(),
+		            [](const auto& info) { return info.type != arg_type::keyword; });
+	if constexpr (has_positional_args)
+	{
+		if (!writer.token("--"))
+		{
+			return false;
+		}
+	}
+
+	return (write_flat_positional<T, Is>(writer, value) && ...);
+}
+
+} // namespace cli151::detail
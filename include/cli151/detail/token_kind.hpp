@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace cli151::detail
+{
+
+enum class token_kind : std::uint8_t
+{
+	positional,
+	// --key, --key=value
+	long_keyword,
+	// -k, -kvalue (for prefix families)
+	short_keyword,
+	// -5, -.5. Positional, unless T has a short name starting with a digit.
+	negative_number,
+	// "--", after which every arg is positional
+	terminator,
+};
+
+// The kind of an arg starting with '-', by its second char.
+inline constexpr auto dash_kinds = []
+{
+	std::array<token_kind, 256> result{};
+	result.fill(token_kind::short_keyword);
+	// A lone dash, usually meaning stdin
+	result['\0'] = token_kind::positional;
+	result['-'] = token_kind::long_keyword;
+	result['.'] = token_kind::negative_number;
+	for (char c = '0'; c <= '9'; ++c)
+	{
+		result[static_cast<unsigned char>(c)] = token_kind::negative_number;
+	}
+	return result;
+}();
+
+// Reads at most the first 3 chars of arg.
+constexpr auto classify_token(const char* arg) -> token_kind
+{
+	if (arg[0] != '-')
+	{
+		return token_kind::positional;
+	}
+	const auto kind = dash_kinds[static_cast<unsigned char>(arg[1])];
+	if (kind == token_kind::long_keyword && arg[2] == '\0')
+	{
+		return token_kind::terminator;
+	}
+	return kind;
+}
+
+} // namespace cli151::detail
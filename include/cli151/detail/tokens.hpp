@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cli151/detail/helpers.hpp>
+#include <cli151/detail/prefixes.hpp>
+#include <cli151/detail/token_kind.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace cli151::detail
+{
+
+// Whether args like -5 are positional for T, which they are unless they could be a short name.
+template <class T>
+consteval auto negative_numbers_are_positional() -> bool
+{
+	const auto numeric = [](std::string_view name)
+	{
+		return !name.empty() &&
+		       dash_kinds[static_cast<unsigned char>(name[0])] == token_kind::negative_number;
+	};
+
+	constexpr auto& keys = keyword_keys<T, false>::keys;
+	constexpr auto& families = prefix_families<T>::entries;
+	return std::none_of(keys.begin(), keys.end(),
+	                    [&](const auto& key) { return numeric(key.name); }) &&
+	       std::none_of(families.begin(), families.end(),
+	                    [&](const auto& family) { return numeric(family.prefix); });
+}
+
+// Classifies argv a block at a time, ahead of the main loop. The first chars of each arg are
+// loaded in a tight loop without any dependency on the parsing, so those loads overlap rather than
+// each stalling the loop that dispatches on them.
+class token_classifier
+{
+  public:
+	constexpr token_classifier(int argc_, const char* const* argv_) : argc{argc_}, argv{argv_} {}
+
+	constexpr auto operator[](int index) -> token_kind
+	{
+		if (index < first || index >= first + block_size)
+		{
+			first = index;
+			const int last = std::min(argc, first + block_size);
+			for (int i = first; i < last; ++i)
+			{
+				kinds[static_cast<std::size_t>(i - first)] = classify_token(argv[i]);
+			}
+		}
+		return kinds[static_cast<std::size_t>(index - first)];
+	}
+
+  private:
+	constexpr static int block_size = 64;
+
+	int argc;
+	const char* const* argv;
+	// The kinds of [first, first + block_size)
+	int first = -block_size;
+	std::array<token_kind, block_size> kinds{};
+};
+
+} // namespace cli151::detail
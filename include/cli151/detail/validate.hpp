@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/fields.hpp>
+#include <cli151/detail/handlers.hpp>
+#include <cli151/detail/output.hpp>
+#include <cli151/detail/parser.hpp>
+#include <cli151/detail/subcommands.hpp>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace cli151::detail
+{
+
+// The type a value of M is converted to when only validating. Containers are skipped in favor of
+// their elements, so nothing is inserted or allocated. Subcommands aren't converted at all, see
+// validate_subcommand.
+template <class M>
+struct scratch_type
+{
+	using type = M;
+};
+
+template <class U>
+struct scratch_type<std::optional<U>> : scratch_type<U>
+{};
+
+template <set_like M>
+struct scratch_type<M> : scratch_type<typename M::value_type>
+{};
+
+template <class T, class Stream>
+auto validate_args(int argc, const char* const* argv, Stream errstream, int& error_index) -> bool;
+
+// Validates the command named by argv[0] against its own args, as parse_subcommand would parse it.
+template <class Stream, class... Ts>
+auto validate_subcommand(std::type_identity<std::variant<Ts...>>, int argc,
+                         const char* const* argv, Stream errstream) -> bool
+{
+	using dispatcher = subcommand_dispatcher<std::variant<Ts...>, Stream>;
+	using validator_t = auto (*)(int, const char* const*, Stream) -> bool;
+
+	constexpr std::array<validator_t, sizeof...(Ts)> index_to_validator_map{
+		[](int command_argc, const char* const* command_argv, Stream command_errstream)
+		{
+			int error_index = command_argc;
+			return validate_args<Ts>(command_argc, command_argv, command_errstream, error_index);
+		}...,
+	};
+
+	const std::string_view name = argv[0];
+	const auto it = dispatcher::name_to_index_map.find(name);
+	if (it == dispatcher::name_to_index_map.end())
+	{
+		output(errstream, "Unknown subcommand {}", name);
+		return false;
+	}
+	return index_to_validator_map[it->second](argc, argv, errstream);
+}
+
+template <class T, class Stream, class Seq>
+struct validator_impl
+{};
+
+template <class T, class Stream, std::size_t... Is>
+struct validator_impl<T, Stream, std::index_sequence<Is...>>
+{
+	// Same as parse_value_into_struct, except the value is converted into a temporary.
+	template <std::size_t I>
+	static auto check(const int argc, const char* const* argv,
+	                  std::optional<std::string_view> current_value, int& current_index,
+	                  used_args_t<T>& used, Stream errstream) -> bool
+	{
+		using field = flat_arg<T, I>;
+		using owner = typename field::owner;
+
+		if (!mark_used<T, I>(used, errstream))
+		{
+			return false;
+		}
+
+		using M = member_type_of<owner, field::index>;
+
+		if constexpr (std::get<field::index>(meta<owner>::value.args_).options.bit != no_bit)
+		{
+			return true;
+		}
+		else if constexpr (is_variant<M>::value)
+		{
+			// The rest of argv is the command, see parse_value(std::variant&)
+			const int command_index = current_index;
+			current_index = argc;
+			return validate_subcommand(std::type_identity<M>{}, argc - command_index,
+			                           argv + command_index, errstream);
+		}
+		else
+		{
+			typename scratch_type<M>::type scratch{};
+			return parse_field_value<T>(scratch, argc, argv, current_value, current_index,
+			                            errstream);
+		}
+	}
+
+	using checker_t = auto (*)(int, const char* const*, std::optional<std::string_view>, int&,
+	                           used_args_t<T>&, Stream) -> bool;
+
+	constexpr static std::array<checker_t, sizeof...(Is)> index_to_checker_map{
+		check<Is>...,
+	};
+};
+
+template <class T, class Stream>
+using validator = validator_impl<T, Stream, std::make_index_sequence<n_flat_args<T>()>>;
+
+template <class T, class Stream>
+auto validate_args(int argc, const char* const* argv, Stream errstream, int& error_index) -> bool
+{
+	const auto handle = [&](std::size_t handler_index, std::optional<std::string_view> value,
+	                        int& arg_index, used_args_t<T>& used)
+	{
+		const auto checker = validator<T, Stream>::index_to_checker_map[handler_index];
+		return checker(argc, argv, value, arg_index, used, errstream);
+	};
+	// Trailing args are never converted
+	const auto set_trailing = [](std::span<const char* const>) {};
+
+	return parse_args<T>(argc, argv, errstream, parse_options{.error_index = &error_index}, handle,
+	                     set_trailing);
+}
+
+} // namespace cli151::detail
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cli151/detail/enums.hpp>
+
+#include <bitset>
+#include <cstddef>
+#include <type_traits>
+
+namespace cli151
+{
+
+// A std::bitset indexed by the values of an enum. As an option, it is filled from a comma
+// separated list of enumerator names (--features=simd,numa), and repeated options accumulate.
+// The bit of an enumerator is its value minus meta<E>::min (0 by default), see enum_bit_index.
+template <class E, std::size_t N = detail::enum_bit_count<E>()>
+	requires std::is_enum_v<E>
+struct enum_bitset : std::bitset<N>
+{
+	using enum_type = E;
+
+	using std::bitset<N>::set;
+	using std::bitset<N>::test;
+
+	auto test(E value) const -> bool { return test(detail::enum_bit_index(value)); }
+	auto set(E value, bool on = true) -> enum_bitset&
+	{
+		set(detail::enum_bit_index(value), on);
+		return *this;
+	}
+};
+
+namespace detail
+{
+
+template <class E, std::size_t N>
+struct is_enum_bitset<enum_bitset<E, N>> : std::true_type
+{};
+
+} // namespace detail
+
+} // namespace cli151
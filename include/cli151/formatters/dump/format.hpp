@@ -0,0 +1,460 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/compat.hpp>
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/enums.hpp>
+#include <cli151/detail/fields.hpp>
+#include <cli151/detail/helpers.hpp>
+#include <cli151/detail/subcommands.hpp>
+#include <cli151/enum_bitset.hpp>
+#include <cli151/values_view.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace cli151::detail
+{
+
+constexpr auto needs_escape(char c) -> bool
+{
+	return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+constexpr auto escaped_size(std::string_view str) -> std::size_t
+{
+	std::size_t result = 0;
+	for (const char c : str)
+	{
+		const bool named = c == '"' || c == '\\' || c == '\n' || c == '\t' || c == '\r';
+		result += !needs_escape(c) ? 1 : named ? 2 : 6;
+	}
+	return result;
+}
+
+// Writes str, escaped as in a JSON string (without the quotes). Runs of characters which don't
+// need escaping are copied at once.
+template <class Out>
+constexpr auto write_escaped(Out out, std::string_view str) -> Out
+{
+	constexpr std::string_view hex = "0123456789abcdef";
+	while (true)
+	{
+		const auto it = std::find_if(str.begin(), str.end(), needs_escape);
+		out = std::copy(str.begin(), it, out);
+		if (it == str.end())
+		{
+			return out;
+		}
+
+		const char c = *it;
+		*out++ = '\\';
+		switch (c)
+		{
+		case '"':
+		case '\\':
+			*out++ = c;
+			break;
+		case '\n':
+			*out++ = 'n';
+			break;
+		case '\t':
+			*out++ = 't';
+			break;
+		case '\r':
+			*out++ = 'r';
+			break;
+		default:
+			out = std::copy_n("u00", 3, out);
+			*out++ = hex[static_cast<unsigned char>(c) >> 4];
+			*out++ = hex[static_cast<unsigned char>(c) & 0xf];
+			break;
+		}
+		str.remove_prefix(static_cast<std::size_t>(it - str.begin()) + 1);
+	}
+}
+
+// The keys of the (flat) arguments of T, precomputed: "name": for JSON, and name= otherwise.
+template <class T, bool Json>
+struct dump_keys
+{
+  private:
+	constexpr static auto help_data = help_data_of<T>::data;
+
+	constexpr static auto name_of(const detail::help_data& info) -> std::string_view
+	{
+		return info.name.empty() ? info.abbr : info.name;
+	}
+
+	constexpr static auto key_size(std::string_view name) -> std::size_t
+	{
+		return Json ? escaped_size(name) + 3 : name.size() + 1;
+	}
+
+	constexpr static auto total_size = []
+	{
+		std::size_t result = 0;
+		for (const auto& info : help_data)
+		{
+			result += key_size(name_of(info));
+		}
+		return result;
+	}();
+
+	constexpr static auto storage = []
+	{
+		std::array<char, total_size> result{};
+		auto out = result.begin();
+		for (const auto& info : help_data)
+		{
+			if constexpr (Json)
+			{
+				*out++ = '"';
+				out = write_escaped(out, name_of(info));
+				*out++ = '"';
+				*out++ = ':';
+			}
+			else
+			{
+				out = std::copy(name_of(info).begin(), name_of(info).end(), out);
+				*out++ = '=';
+			}
+		}
+		return result;
+	}();
+
+  public:
+	constexpr static auto keys = []
+	{
+		std::array<std::string_view, help_data.size()> result{};
+		std::size_t pos = 0;
+		for (std::size_t i = 0; i < help_data.size(); ++i)
+		{
+			const auto size = key_size(name_of(help_data[i]));
+			result[i] = {storage.data() + pos, size};
+			pos += size;
+		}
+		return result;
+	}();
+};
+
+template <class Out>
+auto write_raw(Out out, std::string_view str) -> Out
+{
+	return std::copy(str.begin(), str.end(), out);
+}
+
+// Strings are quoted in JSON. Otherwise they're written as is, apart from escapes, so that each
+// key=value stays on its own line.
+template <bool Json, class Out>
+auto write_string(Out out, std::string_view str) -> Out
+{
+	if constexpr (Json)
+	{
+		*out++ = '"';
+		out = write_escaped(out, str);
+		*out++ = '"';
+		return out;
+	}
+	else
+	{
+		return write_escaped(out, str);
+	}
+}
+
+// Lists are arrays in JSON, and comma separated otherwise.
+template <bool Json, class Out>
+auto write_list(Out out, const auto& range, auto write_element) -> Out
+{
+	if constexpr (Json)
+	{
+		*out++ = '[';
+	}
+	bool first = true;
+	for (const auto& element : range)
+	{
+		if (!first)
+		{
+			*out++ = ',';
+		}
+		first = false;
+		out = write_element(out, element);
+	}
+	if constexpr (Json)
+	{
+		*out++ = ']';
+	}
+	return out;
+}
+
+template <bool Json, class Out, class T>
+auto dump_struct(Out out, const T& value, std::string_view prefix) -> Out;
+
+/*
+dump_value<Json>(out, value) -> Out
+Writes a single field.
+*/
+
+template <bool Json, class Out>
+auto dump_value(Out out, std::string_view value) -> Out
+{
+	return write_string<Json>(out, value);
+}
+
+template <bool Json, class Out>
+auto dump_value(Out out, const char* value) -> Out
+{
+	if (value == nullptr)
+	{
+		return write_raw(out, Json ? "null" : "");
+	}
+	return write_string<Json>(out, value);
+}
+
+template <bool Json, class Out>
+auto dump_value(Out out, bool value) -> Out
+{
+	return write_raw(out, value ? "true" : "false");
+}
+
+template <bool Json, class Out, class T>
+	requires((std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_floating_point_v<T>)
+auto dump_value(Out out, T value) -> Out
+{
+	if constexpr (Json && std::is_floating_point_v<T>)
+	{
+		// JSON has no inf or nan
+		if (!std::isfinite(value))
+		{
+			return write_raw(out, "null");
+		}
+	}
+	// Promoted so chars are written as the numbers they are parsed from
+	return compat::format_to(out, "{}", +value);
+}
+
+// Enums are written by name. Values without a name are written as numbers.
+template <bool Json, class Out, class E>
+	requires(std::is_enum_v<E> && !enum_flags<E>)
+auto dump_value(Out out, E value) -> Out
+{
+	const auto name = enum_info<E>::name_of(value);
+	if (name.empty())
+	{
+		return compat::format_to(out, "{}", static_cast<std::underlying_type_t<E>>(value));
+	}
+	return write_string<Json>(out, name);
+}
+
+// Bitmask enums and enum_bitset are written as lists of the names of the set enumerators.
+template <bool Json, class Out, enum_flags T>
+auto dump_value(Out out, const T& value) -> Out
+{
+	using enum_type = typename flag_enum<T>::type;
+
+	const auto has = [&](enum_type enumerator)
+	{
+		if constexpr (std::is_enum_v<T>)
+		{
+			return enum_or(value, enumerator) == value;
+		}
+		else
+		{
+			return value.test(enumerator);
+		}
+	};
+
+	std::array<std::string_view, enum_info<enum_type>::names.size()> names{};
+	std::size_t n_names = 0;
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		if (has(enum_info<enum_type>::values[i]))
+		{
+			names[n_names++] = enum_info<enum_type>::names[i];
+		}
+	}
+	return write_list<Json>(out, std::span{names.data(), n_names}, [](Out o, std::string_view name)
+	                        { return write_string<Json>(o, name); });
+}
+
+// pair / tuple / array
+template <bool Json, class Out, class T>
+	requires requires { std::tuple_size<T>::value; }
+auto dump_value(Out out, const T& value) -> Out
+{
+	const auto write_elements = [&](const auto& first, const auto&... rest)
+	{
+		if constexpr (Json)
+		{
+			*out++ = '[';
+		}
+		out = dump_value<Json>(out, first);
+		((*out++ = ',', out = dump_value<Json>(out, rest)), ...);
+		if constexpr (Json)
+		{
+			*out++ = ']';
+		}
+		return out;
+	};
+	return std::apply(write_elements, value);
+}
+
+template <bool Json, class Out>
+auto dump_value(Out out, std::span<const char* const> value) -> Out
+{
+	return write_list<Json>(out, value, [](Out o, const char* element)
+	                        { return write_string<Json>(o, element); });
+}
+
+template <bool Json, class Out, class T>
+auto dump_value(Out out, const values_view<T>& value) -> Out
+{
+	return dump_value<Json>(out, value.raw());
+}
+
+template <bool Json, class Out, class T>
+auto dump_value(Out out, const std::optional<T>& value) -> Out
+{
+	if (!value)
+	{
+		return write_raw(out, Json ? "null" : "");
+	}
+	return dump_value<Json>(out, *value);
+}
+
+template <bool Json, class Out, set_like T>
+auto dump_value(Out out, const T& value) -> Out
+{
+	return write_list<Json>(out, value, [](Out o, const auto& element)
+	                        { return dump_value<Json>(o, element); });
+}
+
+// Subcommands are written as an object holding the chosen command. Without JSON, the name of the
+// command is written, and the lines of the command follow.
+template <bool Json, class Out, class... Ts>
+auto dump_value(Out out, const std::variant<Ts...>& value) -> Out
+{
+	return std::visit(
+		[&]<class C>(const C& command)
+		{
+			constexpr auto name = command_name<C>::value;
+			if constexpr (Json)
+			{
+				*out++ = '{';
+				out = write_string<Json>(out, name);
+				*out++ = ':';
+				out = dump_struct<Json>(out, command, {});
+				*out++ = '}';
+				return out;
+			}
+			else
+			{
+				out = write_raw(out, name);
+				*out++ = '\n';
+				return dump_struct<Json>(out, command, name);
+			}
+		},
+		value);
+}
+
+template <bool Json, class Out, class T, std::size_t... Is>
+auto dump_struct_impl(Out out, const T& value, std::string_view prefix, std::index_sequence<Is...>)
+	-> Out
+{
+	constexpr auto& keys = dump_keys<T, Json>::keys;
+
+	const auto dump_arg = [&]<std::size_t I>()
+	{
+		using field = flat_arg<T, I>;
+		constexpr auto info = std::get<field::index>(meta<typename field::owner>::value.args_);
+		const auto& member = field::get(value).*info.memptr;
+
+		if constexpr (I != 0)
+		{
+			*out++ = Json ? ',' : '\n';
+		}
+		if constexpr (!Json)
+		{
+			if (!prefix.empty())
+			{
+				out = write_raw(out, prefix);
+				*out++ = '.';
+			}
+		}
+		out = write_raw(out, keys[I]);
+
+		if constexpr (info.options.bit != no_bit)
+		{
+			if constexpr (std::is_unsigned_v<std::remove_cvref_t<decltype(member)>>)
+			{
+				out = dump_value<Json>(out, ((member >> info.options.bit) & 1) != 0);
+			}
+			else
+			{
+				out = dump_value<Json>(out, member.test(info.options.bit));
+			}
+		}
+		else
+		{
+			out = dump_value<Json>(out, member);
+		}
+	};
+
+	if constexpr (Json)
+	{
+		*out++ = '{';
+	}
+	(dump_arg.template operator()<Is>(), ...);
+	if constexpr (Json)
+	{
+		*out++ = '}';
+	}
+	return out;
+}
+
+template <bool Json, class Out, class T>
+auto dump_struct(Out out, const T& value, std::string_view prefix) -> Out
+{
+	return dump_struct_impl<Json>(out, value, prefix, std::make_index_sequence<n_flat_args<T>()>());
+}
+
+} // namespace cli151::detail
+
+// {} writes key=value lines, {:j} writes a single line of JSON.
+template <class CharType, class T>
+struct cli151::compat::formatter<cli151::dump_formatter<T>, CharType>
+{
+	bool json = false;
+
+	template <class context>
+	constexpr auto parse(context& ctx) -> typename context::iterator
+	{
+		auto it = ctx.begin();
+		if (it != ctx.end() && *it == 'j')
+		{
+			json = true;
+			++it;
+		}
+		return it;
+	}
+
+	template <class context>
+	constexpr auto format(const cli151::dump_formatter<T>& dump, context& ctx) const ->
+		typename context::iterator
+	{
+		if (json)
+		{
+			return cli151::detail::dump_struct<true>(ctx.out(), dump.value, {});
+		}
+		return cli151::detail::dump_struct<false>(ctx.out(), dump.value, {});
+	}
+};
@@ -3,8 +3,13 @@
 #include <cli151/common.hpp>
 #include <cli151/detail/compat.hpp>
 #include <cli151/detail/helpers.hpp>
+#include <cli151/detail/suggest.hpp>
 #include <cli151/formatters/usage/format.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <string_view>
+
 template <class CharType, class T>
 struct cli151::compat::formatter<cli151::error_formatter<T>, CharType>
 {
@@ -37,9 +42,21 @@ struct cli151::compat::formatter<cli151::error_formatter<T>, CharType>
 		switch (err.err.type)
 		{
 		case error_type::invalid_key:
-			format_to(ctx.out(), "Unknown option \"{}\". Available options:\n",
-			          err.argv[err.err.arg_index]);
+		{
+			const std::string_view arg = err.argv[err.err.arg_index];
+			format_to(ctx.out(), "Unknown option \"{}\".", arg);
+			if (arg.starts_with("--"))
+			{
+				const auto key = arg.substr(2, arg.find_first_of(":= ") - 2);
+				if (const auto suggestion = cli151::detail::suggest_keyword<T>(key);
+				    !suggestion.empty())
+				{
+					format_to(ctx.out(), " Did you mean --{}?", suggestion);
+				}
+			}
+			format_to(ctx.out(), " Available options:\n");
 			return format_options(help_data, ctx);
+		}
 		case error_type::not_a_number:
 			format_to(ctx.out(), "Not a number\n");
 			// Let's not overcomplicate this. Just print which one is wrong, say it should be a
@@ -59,7 +76,6 @@ struct cli151::compat::formatter<cli151::error_formatter<T>, CharType>
 		case error_type::not_enough_positional_args:
 			format_to(ctx.out(), "Not enough positional args, expected {}, got {}\n",
 			          n_positional_args, "not enough");
-			// We don't actually check this yet
 			break;
 		case error_type::duplicate_arg:
 			// TODO: Aliases might make this confusing
@@ -102,6 +118,8 @@ struct cli151::compat::formatter<cli151::error_formatter<T>, CharType>
 	constexpr auto format_options(const auto& help_data, context& ctx) const ->
 		typename context::iterator
 	{
+		using cli151::compat::format_to;
+
 		for (const auto& data : help_data)
 		{
 			if (data.type == cli151::arg_type::keyword)
@@ -32,6 +32,14 @@ struct cli151::compat::formatter<cli151::usage_formatter<T>, CharType>
 			}
 		}
 		// TODO: skip [OPTIONS] if no keyword args
-		return format_to(ctx.out(), " [OPTIONS]");
+		format_to(ctx.out(), " [OPTIONS]");
+		for (const auto& data : help_data)
+		{
+			if (data.type == cli151::arg_type::trailing)
+			{
+				format_to(ctx.out(), " [--] [{}...]", data.name);
+			}
+		}
+		return ctx.out();
 	}
 };
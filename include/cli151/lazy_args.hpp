@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cli151/common.hpp>
+#include <cli151/detail/bitmask.hpp>
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/enums.hpp>
+#include <cli151/detail/fields.hpp>
+#include <cli151/detail/handlers.hpp>
+#include <cli151/detail/parser.hpp>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cli151
+{
+
+template <class T, class Stream>
+class lazy_args;
+
+namespace detail
+{
+
+template <class T, class Stream, class Seq>
+struct lazy_fingerprinter_impl;
+
+template <class T>
+struct is_single_value
+	: std::bool_constant<(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) ||
+                         (std::is_enum_v<T> && !enum_flags<T>) ||
+                         std::is_same_v<T, std::string_view> || std::is_same_v<T, const char*>>
+{};
+
+template <class T>
+struct is_single_value<std::optional<T>> : is_single_value<T>
+{};
+
+// Whether the Ith (flat) argument of T is converted on first access, rather than while parsing.
+// Only args taking exactly one value are, the rest are either cheap to parse (flags, views of
+// argv) or need every occurrence (sets).
+template <class T, std::size_t I>
+consteval auto is_lazy_arg() -> bool
+{
+	using field = flat_arg<T, I>;
+	using owner = typename field::owner;
+	return std::get<field::index>(meta<owner>::value.args_).options.bit == no_bit &&
+	       is_single_value<member_type_of<owner, field::index>>::value;
+}
+
+template <class T, class Stream, class Seq>
+struct lazy_parser_impl
+{};
+
+template <class T, class Stream, std::size_t... Is>
+struct lazy_parser_impl<T, Stream, std::index_sequence<Is...>>
+{
+	using result_t = lazy_args<T, Stream>;
+
+	// Same as parse_value_into_struct, except that single values are only recorded.
+	template <std::size_t I>
+	static auto record(result_t& out, const int argc, const char* const* argv,
+	                   std::optional<std::string_view> current_value, int& current_index,
+	                   used_args_t<T>& used, Stream errstream) -> bool
+	{
+		if constexpr (is_lazy_arg<T, I>())
+		{
+			if (!mark_used<T, I>(used, errstream))
+			{
+				return false;
+			}
+			const auto value = get_next_value(argc, argv, current_value, current_index, errstream);
+			if (!value)
+			{
+				return false;
+			}
+			out.values[I] = *value;
+			out.pending.set(I);
+			return true;
+		}
+		else
+		{
+			return parse_value_into_struct<T, I>(out.cache, argc, argv, current_value,
+			                                     current_index, used, errstream);
+		}
+	}
+
+	using recorder_t = auto (*)(result_t&, int, const char* const*,
+	                            std::optional<std::string_view>, int&, used_args_t<T>&, Stream)
+		-> bool;
+
+	constexpr static std::array<recorder_t, sizeof...(Is)> index_to_recorder_map{
+		record<Is>...,
+	};
+
+	static auto parse(int argc, const char* const* argv, Stream errstream)
+		-> std::optional<result_t>
+	{
+		result_t result{errstream};
+
+		const auto handle = [&](std::size_t handler_index, std::optional<std::string_view> value,
+		                        int& arg_index, used_args_t<T>& used)
+		{
+			const auto recorder = index_to_recorder_map[handler_index];
+			return recorder(result, argc, argv, value, arg_index, used, errstream);
+		};
+
+		const auto set_trailing = [&](std::span<const char* const> rest)
+		{ set_trailing_args(result.cache, rest); };
+
+		if (!parse_args<T>(argc, argv, errstream, parse_options{}, handle, set_trailing))
+		{
+			return {};
+		}
+		return result;
+	}
+
+	// Converts the Ith argument, if it was given and hasn't been converted yet.
+	template <std::size_t I>
+	static auto convert(result_t& out) -> bool
+	{
+		if constexpr (is_lazy_arg<T, I>())
+		{
+			if (out.pending.test(I))
+			{
+				using field = flat_arg<T, I>;
+				constexpr auto memptr =
+					std::get<field::index>(meta<typename field::owner>::value.args_).memptr;
+
+				out.pending.reset(I);
+				// The value is always given, so argv is never read.
+				int unused_index = 0;
+				if (!parse_value(field::get(out.cache).*memptr, 0, nullptr, out.values[I],
+				                 unused_index, out.errstream))
+				{
+					out.failed.set(I);
+				}
+			}
+		}
+		return !out.failed.test(I);
+	}
+
+	template <std::size_t First, std::size_t... Js>
+	static auto convert_range(result_t& out, std::index_sequence<Js...>) -> bool
+	{
+		return (convert<First + Js>(out) && ...);
+	}
+};
+
+template <class T, class Stream>
+using lazy_parser = lazy_parser_impl<T, Stream, std::make_index_sequence<n_flat_args<T>()>>;
+
+} // namespace detail
+
+// The result of parse_lazy. The structure of the args has been checked, but fields taking a single
+// value are only converted (and then cached) on first access.
+template <class T, class Stream>
+class lazy_args
+{
+  public:
+	// Returns the field, converting it if needed. For an option group, this converts the whole
+	// group. If the value can't be converted, the error is reported as parse would, and this
+	// returns nullptr (on this and every later access).
+	template <auto Memptr>
+	auto get() -> const typename detail::pointer_to_member<decltype(Memptr)>::member*
+	{
+		constexpr auto range = detail::flat_range_of<T, Memptr>(
+			std::make_index_sequence<meta<T>::value.n_args>());
+		if (!detail::lazy_parser<T, Stream>::template convert_range<range.first>(
+				*this, std::make_index_sequence<range.second>()))
+		{
+			return nullptr;
+		}
+		return &(cache.*Memptr);
+	}
+
+  private:
+	friend detail::lazy_parser<T, Stream>;
+	template <class, class, class>
+	friend struct detail::lazy_fingerprinter_impl;
+
+	explicit lazy_args(Stream errstream_) : errstream{errstream_} {}
+
+	T cache{};
+	// The unconverted values of the lazy args, by flat index
+	std::array<std::string_view, detail::n_flat_args<T>()> values{};
+	// Lazy args which were given, but not yet converted
+	detail::used_args_t<T> pending;
+	detail::used_args_t<T> failed;
+	Stream errstream;
+};
+
+} // namespace cli151
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 #define CLI151_CLI(STRUCT_NAME, ...)                                                               \
 	template <>                                                                                    \
 	struct cli151::meta<STRUCT_NAME>                                                               \
@@ -7,3 +9,16 @@
 		using T = STRUCT_NAME;                                                                     \
 		constexpr static auto value = args{__VA_ARGS__};                                           \
 	};
+
+// Shares the parser of STRUCT_NAME between TUs. CLI151_DECLARE_PARSER goes after the meta of
+// STRUCT_NAME, in the header declaring it, and CLI151_DEFINE_PARSER in exactly one source file.
+// Then cli151::parse<STRUCT_NAME>(argc, argv) (with the default error stream) only instantiates
+// the parser in that source file, and other TUs call it.
+#define CLI151_DECLARE_PARSER(STRUCT_NAME)                                                         \
+	template <>                                                                                    \
+	struct cli151::detail::has_shared_parser<STRUCT_NAME> : std::true_type                         \
+	{};                                                                                            \
+	extern template struct cli151::detail::shared_parser<STRUCT_NAME>;
+
+#define CLI151_DEFINE_PARSER(STRUCT_NAME)                                                          \
+	template struct cli151::detail::shared_parser<STRUCT_NAME>;
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/handlers.hpp>
+#include <cli151/detail/output.hpp>
+#include <cli151/values_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace cli151
+{
+
+// A keyword option which is only known at runtime, see option_registry.
+struct registered_option
+{
+	// Matches --name. An empty name marks an unused slot.
+	std::string_view name;
+	// Called with the value of each occurrence (nothing for flags). Returns false if the value is
+	// invalid.
+	auto (*sink)(void* target, std::optional<std::string_view> value) -> bool = nullptr;
+	void* target = nullptr;
+	bool takes_value = true;
+};
+
+namespace detail
+{
+
+// An output iterator which drops everything written to it, for conversions whose errors are
+// reported elsewhere.
+struct discard_iterator
+{
+	using difference_type = std::ptrdiff_t;
+
+	auto operator*() -> discard_iterator& { return *this; }
+	auto operator=(char) -> discard_iterator& { return *this; }
+	auto operator++() -> discard_iterator& { return *this; }
+	auto operator++(int) -> discard_iterator { return *this; }
+};
+
+// FNV-1a
+constexpr auto hash_keyword(std::string_view key) -> std::uint64_t
+{
+	std::uint64_t hash = 0xcbf29ce484222325;
+	for (const char c : key)
+	{
+		hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+	}
+	return hash;
+}
+
+// Whether a value of T is read from a single arg, so that it can be registered at runtime. The
+// sink of a registered option is only given the value of its own arg, not the rest of argv.
+template <class T>
+consteval auto takes_single_value() -> bool
+{
+	if constexpr (is_optional<T>::value || set_like<T>)
+	{
+		return takes_single_value<typename T::value_type>();
+	}
+	else if constexpr (requires { std::tuple_size<T>::value; })
+	{
+		if constexpr (std::tuple_size_v<T> == 1)
+		{
+			return takes_single_value<std::tuple_element_t<0, T>>();
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else
+	{
+		return !is_variant<T>::value && !is_argv_view<T>::value;
+	}
+}
+
+} // namespace detail
+
+// Keyword options added at runtime (for example by plugins), for keywords that aren't arguments
+// of the struct being parsed. See parse_dynamic.
+// The options are stored in an open addressing hash table, in caller provided slots. Nothing is
+// allocated, either while adding options or while parsing.
+class option_registry
+{
+  public:
+	// The table never gets more than 3/4 full, so slots should have room for a third more than the
+	// number of options.
+	explicit option_registry(std::span<registered_option> slots_) : slots{slots_}
+	{
+		for (auto& slot : slots)
+		{
+			slot = {};
+		}
+	}
+
+	// Returns false if the name is empty or already registered, or if the table is full.
+	auto add(const registered_option& option) -> bool
+	{
+		if (option.name.empty() || option.sink == nullptr || (size + 1) * 4 > slots.size() * 3)
+		{
+			return false;
+		}
+		auto& slot = probe(option.name);
+		if (!slot.name.empty())
+		{
+			return false;
+		}
+		slot = option;
+		++size;
+		return true;
+	}
+
+	// Adds --name, converted into target like a keyword field of the struct, except that only
+	// types read from a single arg are supported (so no pairs, tuples, arrays, or multi-value
+	// args), and that repeating the option isn't an error. Each occurrence is converted in turn:
+	// the last value is kept, a bool target is flipped, and set-like targets accumulate. target
+	// must outlive any parse using this registry.
+	template <class V>
+	auto add(std::string_view name, V& target) -> bool
+	{
+		static_assert(!detail::is_argv_view<V>::value,
+		              "Multi-value options can't be registered at runtime");
+		static_assert(detail::takes_single_value<V>(),
+		              "Only options taking a single value can be registered at runtime");
+
+		const auto sink = [](void* target_, std::optional<std::string_view> value)
+		{
+			// The value is always given, so argv is never read.
+			int unused_index = 0;
+			return detail::parse_value(*static_cast<V*>(target_), 0, nullptr, value, unused_index,
+			                           detail::discard_iterator{});
+		};
+		return add({name, sink, &target, !std::is_same_v<V, bool>});
+	}
+
+	auto find(std::string_view name) const -> const registered_option*
+	{
+		if (size == 0)
+		{
+			return nullptr;
+		}
+		const auto& slot = probe(name);
+		return slot.name.empty() ? nullptr : &slot;
+	}
+
+  private:
+	// The slot holding name, or the empty slot where it would go. Linear probing, which always
+	// ends since the table is never full.
+	auto probe(std::string_view name) const -> registered_option&
+	{
+		auto index = detail::hash_keyword(name) % slots.size();
+		while (!slots[index].name.empty() && slots[index].name != name)
+		{
+			index = index + 1 == slots.size() ? 0 : index + 1;
+		}
+		return slots[index];
+	}
+
+	std::span<registered_option> slots;
+	std::size_t size = 0;
+};
+
+namespace detail
+{
+
+// Parses a keyword found in registry. As with the static args, the value may be joined to the key
+// or be the next arg.
+template <class Stream>
+auto parse_registered(const registered_option& option, std::optional<std::string_view> value,
+                      const int argc, const char* const* argv, int& current_index,
+                      Stream errstream) -> bool
+{
+	if (!option.takes_value)
+	{
+		return option.sink(option.target, {});
+	}
+
+	const auto result = get_next_value(argc, argv, value, current_index, errstream);
+	if (!result)
+	{
+		return false;
+	}
+	if (!option.sink(option.target, result))
+	{
+		output(errstream, "Invalid value ({}) for --{}", *result, option.name);
+		return false;
+	}
+	return true;
+}
+
+} // namespace detail
+
+} // namespace cli151
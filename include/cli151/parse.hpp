@@ -0,0 +1,46 @@
+#pragma once
+
+// Only parse, without the formatting library (or the rest of cli151.hpp). Errors are written to a
+// FILE*, an output iterator of chars, null_sink, or a sink with a report_error overload.
+
+#include <cli151/common.hpp>
+#include <cli151/detail/parser.hpp>
+
+#include <cstdio>
+#include <optional>
+#include <type_traits>
+
+namespace cli151
+{
+
+// With cli151::null_sink as the error stream, this can be used in a constant expression, as long
+// as T is a literal type (so no std::set), and floating point values are exact, see
+// constant_from_chars. A command line that doesn't parse then fails the build:
+//     constexpr auto config = cli151::parse<T>(args.size(), args.data(), cli151::null_sink{});
+//     static_assert(config);
+template <class T, class Stream = FILE*>
+constexpr auto parse(int argc, const char* const* argv, [[maybe_unused]] Stream errstream = stderr)
+	-> std::optional<T>
+{
+	// Instantiated elsewhere, see CLI151_DECLARE_PARSER
+	if constexpr (std::is_same_v<Stream, FILE*> && detail::has_shared_parser<T>::value)
+	{
+		return detail::shared_parser<T>::parse(argc, argv, errstream);
+	}
+	else
+	{
+		// T is probably an aggregate. We 0-initialize (or whichever type of initialization C++
+		// calls this) the result to prevent random values from appearing. Not sure if this should
+		// be part of the public API, but could prevent some cryptic bugs.
+		T result{};
+
+		if (!detail::parse_into(result, argc, argv, errstream))
+		{
+			return {};
+		}
+
+		return result;
+	}
+}
+
+} // namespace cli151
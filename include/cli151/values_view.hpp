@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cli151/detail/concepts.hpp>
+#include <cli151/detail/convert.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace cli151
+{
+
+// A typed view over consecutive elements of argv, as filled in by multi-value options
+// (--files a.txt b.txt). Nothing is copied or converted while parsing, each element is converted
+// to T only when it is accessed.
+template <class T>
+class values_view
+{
+  public:
+	struct iterator
+	{
+		using value_type = std::optional<T>;
+		using difference_type = std::ptrdiff_t;
+
+		const char* const* pos = nullptr;
+
+		auto operator*() const -> std::optional<T> { return values_view::convert(*pos); }
+		auto operator++() -> iterator&
+		{
+			++pos;
+			return *this;
+		}
+		auto operator++(int) -> iterator
+		{
+			auto copy = *this;
+			++pos;
+			return copy;
+		}
+		auto operator==(const iterator&) const -> bool = default;
+	};
+
+	constexpr values_view() = default;
+	constexpr explicit values_view(std::span<const char* const> raw_) : raw_values{raw_} {}
+
+	// The unconverted arguments, pointing directly into argv.
+	constexpr auto raw() const -> std::span<const char* const> { return raw_values; }
+	constexpr auto size() const -> std::size_t { return raw_values.size(); }
+	constexpr auto empty() const -> bool { return raw_values.empty(); }
+
+	// Converts the ith value. Returns std::nullopt if it cannot be converted to T.
+	auto operator[](std::size_t i) const -> std::optional<T> { return convert(raw_values[i]); }
+
+	auto begin() const -> iterator { return {raw_values.data()}; }
+	auto end() const -> iterator { return {raw_values.data() + raw_values.size()}; }
+
+  private:
+	static auto convert(std::string_view str) -> std::optional<T>
+	{
+		T result{};
+		if (detail::convert_value(str, result) != std::errc())
+		{
+			return {};
+		}
+		return result;
+	}
+
+	std::span<const char* const> raw_values;
+};
+
+namespace detail
+{
+
+template <class T>
+struct is_argv_view<values_view<T>> : std::true_type
+{};
+
+} // namespace detail
+
+} // namespace cli151
@@ -0,0 +1,78 @@
+// The cli151 module, for `import cli151;` instead of including the headers.
+// The headers are included in the global module fragment, so their dependencies (frozen, fmt or
+// <print>, fast_float or <charconv>) are only used to build this module. Importers only see the
+// names exported below, and the macros in macros.hpp can still be used by including it.
+module;
+
+#include <cli151/cli151.hpp>
+#include <cli151/formatters/dump/format.hpp>
+#include <cli151/formatters/error/format.hpp>
+#include <cli151/formatters/usage/format.hpp>
+
+export module cli151;
+
+export namespace cli151
+{
+
+// Declaring arguments
+using cli151::arg;
+using cli151::arg_type;
+using cli151::args;
+using cli151::default_;
+using cli151::meta;
+using cli151::no_bit;
+using cli151::none;
+using cli151::opt;
+
+// Argument types
+using cli151::enum_bitset;
+using cli151::values_view;
+
+// Parsing
+using cli151::arg_index;
+using cli151::known_args;
+using cli151::lazy_args;
+using cli151::null_sink;
+using cli151::option_registry;
+using cli151::owned;
+using cli151::owned_size;
+using cli151::parse;
+using cli151::parse_dynamic;
+using cli151::parse_events;
+using cli151::parse_known;
+using cli151::parse_lazy;
+using cli151::parse_owned;
+using cli151::rebase_strings;
+using cli151::registered_option;
+using cli151::validate;
+using cli151::validate_result;
+
+// Using the results
+using cli151::fingerprint;
+using cli151::hash128;
+using cli151::to_argv;
+
+// Formatters
+using cli151::dump_formatter;
+using cli151::error;
+using cli151::error_formatter;
+using cli151::error_type;
+using cli151::help_formatter;
+using cli151::usage_formatter;
+
+// To print the formatters without depending on fmt or <print> directly
+namespace compat
+{
+using cli151::compat::format_to;
+using cli151::compat::print;
+using cli151::compat::println;
+} // namespace compat
+
+// Named by CLI151_DECLARE_PARSER and CLI151_DEFINE_PARSER in macros.hpp
+namespace detail
+{
+using cli151::detail::has_shared_parser;
+using cli151::detail::shared_parser;
+} // namespace detail
+
+} // namespace cli151
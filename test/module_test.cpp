@@ -0,0 +1,63 @@
+// Checks that the module exports what's needed to declare, parse and print a cli.
+import cli151;
+
+#include <cli151/macros.hpp>
+
+#include <array>
+#include <optional>
+#include <string_view>
+
+namespace cli = cli151;
+
+struct mycli
+{
+	int number;
+	std::string_view name;
+	std::optional<std::string_view> author;
+	bool flag = false;
+};
+
+template <>
+struct cli::meta<mycli>
+{
+	using T = mycli;
+	constexpr static auto value = args{
+		arg{&T::number, {.help = "The number", .abbr = "r"}},
+		&T::name,
+		&T::author,
+		&T::flag,
+	};
+};
+
+struct macro_cli
+{
+	std::string_view first, last;
+};
+CLI151_CLI(macro_cli, &T::first, &T::last)
+CLI151_DECLARE_PARSER(macro_cli)
+CLI151_DEFINE_PARSER(macro_cli)
+
+int main()
+{
+	constexpr std::array args{"main", "1", "bob", "--author", "alice", "-f"};
+	const auto result = cli::parse<mycli>(args.size(), args.data());
+	if (!result || result->number != 1 || result->name != "bob" || result->author != "alice" ||
+	    !result->flag)
+	{
+		return 1;
+	}
+
+	constexpr std::array macro_args{"main", "Ada", "Lovelace"};
+	if (!cli::parse<macro_cli>(macro_args.size(), macro_args.data(), cli::null_sink{}))
+	{
+		return 1;
+	}
+	// Through the shared parser
+	if (!cli::parse<macro_cli>(macro_args.size(), macro_args.data()))
+	{
+		return 1;
+	}
+
+	cli::compat::println("{}", cli::usage_formatter<mycli>{"main"});
+	cli::compat::println("{}", cli::dump_formatter<mycli>{*result});
+}
@@ -1,16 +1,27 @@
 #include <cli151/cli151.hpp>
+#include <cli151/formatters/dump/format.hpp>
+#include <cli151/formatters/error/format.hpp>
 namespace cli = cli151;
 
 // Needs quotes for bazel setup, see https://github.com/doctest/doctest/issues/927
 #include "doctest/doctest.h"
 
+#include <algorithm>
 #include <array>
+#include <bitset>
 #include <cstdint>
+#include <iterator>
+#include <limits>
 #include <set>
+#include <span>
+#include <string>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <unordered_set>
 #include <utility>
+#include <variant>
+#include <vector>
 
 // For now, error tests only check that the parse failed. These tests should be extended once the
 // error interface is more stable.
@@ -46,12 +57,12 @@ TEST_CASE("positional args")
 	CHECK(a6 == "charlie");
 }
 
-// TEST_CASE("positional args (not enough)")
-// {
-// 	constexpr std::array args{"main", "123"};
-// 	const auto result = cli::parse<positional_only>(args.size(), args.data());
-// 	REQUIRE(!result);
-// }
+TEST_CASE("positional args (not enough)")
+{
+	constexpr std::array args{"main", "123"};
+	const auto result = cli::parse<positional_only>(args.size(), args.data());
+	REQUIRE(!result);
+}
 
 TEST_CASE("positional args (too many)")
 {
@@ -435,21 +446,1728 @@ TEST_CASE("std::array")
 	CHECK(result.value().values == std::array<int, 5>{10, 20, 30, 40, 50});
 }
 
-#include <cli151/macros.hpp>
+struct multi_values
+{
+	std::optional<int> count;
+	std::span<const char* const> files;
+	cli::values_view<int> sizes;
+};
+template <>
+struct cli::meta<multi_values>
+{
+	using T = multi_values;
+	constexpr static auto value = args{&T::count, &T::files, &T::sizes};
+};
 
-struct cli2
+TEST_CASE("Multi-value options")
 {
-	std::string_view first, middle, last;
+	constexpr std::array args{"main", "--files", "a.txt", "b.txt", "c.txt",
+	                          "-s",   "10",      "x",     "30",    "--count=2"};
+	const auto result = cli::parse<multi_values>(args.size(), args.data());
+	REQUIRE(result);
+
+	const auto& files = result.value().files;
+	REQUIRE(files.size() == 3);
+	// The values point directly into argv
+	CHECK(files.data() == args.data() + 2);
+	CHECK(std::string_view{files[2]} == "c.txt");
+
+	const auto& sizes = result.value().sizes;
+	REQUIRE(sizes.size() == 3);
+	CHECK(sizes[0] == 10);
+	CHECK(!sizes[1].has_value());
+	CHECK(sizes[2] == 30);
+	CHECK(result.value().count == 2);
+}
+
+TEST_CASE("Multi-value options (empty)")
+{
+	constexpr std::array args{"main", "--files", "--count", "2"};
+	const auto result = cli::parse<multi_values>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(result.value().files.empty());
+	CHECK(result.value().sizes.empty());
+}
+
+TEST_CASE("Multi-value options (failure)")
+{
+	constexpr std::array joined{"main", "--files=a.txt", "b.txt"};
+	CHECK(!cli::parse<multi_values>(joined.size(), joined.data()));
+
+	constexpr std::array duplicate{"main", "--files", "a.txt", "--files", "b.txt"};
+	CHECK(!cli::parse<multi_values>(duplicate.size(), duplicate.data()));
+}
+
+struct launcher
+{
+	std::optional<int> cpus;
+	bool verbose = false;
+	std::span<const char* const> command;
+};
+template <>
+struct cli::meta<launcher>
+{
+	using T = launcher;
+	constexpr static auto value = args{
+		&T::cpus,
+		&T::verbose,
+		arg{&T::command, {.type = cli::arg_type::trailing}},
+	};
 };
-CLI151_CLI(cli2, &T::first, &T::middle, &T::last)
 
-TEST_CASE("Macro definition")
+TEST_CASE("Trailing args after --")
 {
-	constexpr std::array args{"main", "Francesco", "Von", "Pellegreno"};
-	const auto result = cli::parse<cli2>(args.size(), args.data());
+	constexpr std::array args{"main", "--cpus", "4", "--", "./worker", "--verbose", "-x"};
+	const auto result = cli::parse<launcher>(args.size(), args.data());
 	REQUIRE(result);
 
-	CHECK(result.value().first == "Francesco");
-	CHECK(result.value().middle == "Von");
-	CHECK(result.value().last == "Pellegreno");
+	CHECK(result.value().cpus == 4);
+	CHECK(!result.value().verbose);
+	const auto command = result.value().command;
+	REQUIRE(command.size() == 3);
+	CHECK(command.data() == args.data() + 4);
+	CHECK(std::string_view{command[1]} == "--verbose");
+}
+
+TEST_CASE("Trailing args from the first extra positional")
+{
+	constexpr std::array args{"main", "-v", "./worker", "--cpus", "8"};
+	const auto result = cli::parse<launcher>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(!result.value().cpus.has_value());
+	CHECK(result.value().verbose);
+	REQUIRE(result.value().command.size() == 3);
+	CHECK(std::string_view{result.value().command[0]} == "./worker");
+}
+
+TEST_CASE("Trailing args (empty)")
+{
+	constexpr std::array args{"main", "-c", "2", "--"};
+	const auto result = cli::parse<launcher>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(result.value().command.empty());
+}
+
+TEST_CASE("-- ends keyword args")
+{
+	constexpr std::array args{"main", "--", "-5", "--not-a-keyword", "-7", "--", "-8.5", "-bob"};
+	const auto result = cli::parse<positional_only>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(result.value().arg1 == -5);
+	CHECK(result.value().arg2 == "--not-a-keyword");
+	CHECK(result.value().arg4 == "--");
+	CHECK(result.value().arg5 == -8.5);
+	CHECK(result.value().arg6 == "-bob");
+}
+
+enum class log_level
+{
+	trace,
+	debug,
+	info,
+	warning_only,
+};
+
+enum class feature : unsigned
+{
+	simd = 1 << 0,
+	numa = 1 << 1,
+	huge_pages = 1 << 4,
+};
+template <>
+struct cli::meta<feature>
+{
+	constexpr static bool bitmask = true;
+};
+
+enum class codec
+{
+	h264 = 2,
+	vp9 = 5,
+	av1 = 9,
+};
+
+struct enums
+{
+	log_level level;
+	std::optional<codec> codec_;
+	feature features{};
+	cli::enum_bitset<codec> allowed_codecs;
+};
+template <>
+struct cli::meta<enums>
+{
+	using T = enums;
+	constexpr static auto value = args{
+		&T::level,
+		arg{&T::codec_, {.arg_name = "codec"}},
+		&T::features,
+		&T::allowed_codecs,
+	};
+};
+
+TEST_CASE("Enums")
+{
+	constexpr std::array args{
+		"main", "warning-only", "--codec=vp9", "--features=simd,huge-pages", "-a", "av1,h264",
+	};
+	const auto result = cli::parse<enums>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(result.value().level == log_level::warning_only);
+	CHECK(result.value().codec_ == codec::vp9);
+	CHECK(static_cast<unsigned>(result.value().features) ==
+	      (static_cast<unsigned>(feature::simd) | static_cast<unsigned>(feature::huge_pages)));
+	CHECK(result.value().allowed_codecs.test(codec::av1));
+	CHECK(result.value().allowed_codecs.test(codec::h264));
+	CHECK(!result.value().allowed_codecs.test(codec::vp9));
+}
+
+TEST_CASE("Enums (repeated flags accumulate)")
+{
+	constexpr std::array args{"main",       "info", "-f",     "numa",
+	                          "--features", "simd", "-a=vp9", "-a=av1"};
+	const auto result = cli::parse<enums>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(static_cast<unsigned>(result.value().features) ==
+	      (static_cast<unsigned>(feature::simd) | static_cast<unsigned>(feature::numa)));
+	CHECK(result.value().allowed_codecs.count() == 2);
+}
+
+enum class signed_feature
+{
+	neg = -1,
+	a,
+	b,
+};
+template <>
+struct cli::meta<signed_feature>
+{
+	constexpr static int min = -1;
+};
+
+struct signed_flags
+{
+	cli::enum_bitset<signed_feature> f;
+};
+template <>
+struct cli::meta<signed_flags>
+{
+	using T = signed_flags;
+	constexpr static auto value = args{&T::f};
+};
+
+TEST_CASE("Enums (negative enumerators in a bitset)")
+{
+	static_assert(cli::enum_bitset<signed_feature>{}.size() == 3);
+
+	constexpr std::array args{"main", "--f", "neg,b"};
+	const auto result = cli::parse<signed_flags>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->f.test(signed_feature::neg));
+	CHECK(!result->f.test(signed_feature::a));
+	CHECK(result->f.test(signed_feature::b));
+	CHECK(result->f.test(0));
+}
+
+TEST_CASE("Enums (failure)")
+{
+	constexpr std::array unknown{"main", "loud"};
+	CHECK(!cli::parse<enums>(unknown.size(), unknown.data()));
+
+	constexpr std::array unknown_flag{"main", "info", "--features=simd,avx"};
+	CHECK(!cli::parse<enums>(unknown_flag.size(), unknown_flag.data()));
+
+	constexpr std::array duplicate{"main", "info", "--codec=vp9", "--codec=av1"};
+	CHECK(!cli::parse<enums>(duplicate.size(), duplicate.data()));
+}
+
+struct bit_flags
+{
+	std::bitset<100> f;
+	std::uint32_t w = 0b100;
+	bool verbose = false;
+};
+template <>
+struct cli::meta<bit_flags>
+{
+	using T = bit_flags;
+	constexpr static auto value = args{
+		arg{&T::f, {.abbr = cli::none, .arg_name = "fomit-frame-pointer", .bit = 0}},
+		arg{&T::f, {.abbr = cli::none, .arg_name = "fstrict-aliasing", .bit = 42}},
+		arg{&T::f, {.abbr = cli::none, .arg_name = "funroll-loops", .bit = 99}},
+		arg{&T::w, {.abbr = "a", .arg_name = "warn-all", .bit = 0}},
+		arg{&T::w, {.abbr = "e", .arg_name = "warn-error", .bit = 2}},
+		&T::verbose,
+	};
+};
+
+TEST_CASE("Bit flags")
+{
+	constexpr std::array args{
+		"main", "--fstrict-aliasing", "--funroll-loops", "-a", "--warn-error", "-v",
+	};
+	const auto result = cli::parse<bit_flags>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(!result.value().f.test(0));
+	CHECK(result.value().f.test(42));
+	CHECK(result.value().f.test(99));
+	CHECK(result.value().f.count() == 2);
+	// Like bools, bits are flipped
+	CHECK(result.value().w == 0b001);
+	CHECK(result.value().verbose);
+}
+
+TEST_CASE("Bit flags (duplicate)")
+{
+	constexpr std::array args{"main", "--funroll-loops", "--fstrict-aliasing", "--funroll-loops"};
+	const auto result = cli::parse<bit_flags>(args.size(), args.data());
+	REQUIRE(!result);
+}
+
+struct constrained
+{
+	std::optional<std::string_view> output;
+	bool to_stdout = false;
+	bool quiet = false;
+	std::optional<std::string_view> user;
+	std::optional<std::string_view> password;
+	std::optional<int> jobs;
+};
+template <>
+struct cli::meta<constrained>
+{
+	using T = constrained;
+	constexpr static auto value = args{
+		arg{&T::output, {.exclusive_group = "out"}},
+		arg{&T::to_stdout, {.abbr = "s", .exclusive_group = "out"}},
+		arg{&T::quiet, {.exclusive_group = "out"}},
+		arg{&T::user, {.depends_on = "password"}},
+		&T::password,
+		arg{&T::jobs, {.required = true}},
+	};
+};
+
+TEST_CASE("Constraints")
+{
+	constexpr std::array args{"main", "-j", "4", "-o", "file", "--user", "me", "-p", "hunter2"};
+	const auto result = cli::parse<constrained>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(result.value().jobs == 4);
+	CHECK(result.value().output == "file");
+}
+
+TEST_CASE("Constraints (missing required)")
+{
+	constexpr std::array args{"main", "-o", "file"};
+	const auto result = cli::parse<constrained>(args.size(), args.data());
+	REQUIRE(!result);
+}
+
+TEST_CASE("Constraints (mutually exclusive)")
+{
+	constexpr std::array args{"main", "-j", "4", "-s", "--quiet"};
+	const auto result = cli::parse<constrained>(args.size(), args.data());
+	REQUIRE(!result);
+}
+
+TEST_CASE("Constraints (missing dependency)")
+{
+	constexpr std::array args{"main", "-j", "4", "--user", "me"};
+	const auto result = cli::parse<constrained>(args.size(), args.data());
+	REQUIRE(!result);
+}
+
+struct logging_opts
+{
+	std::optional<std::string_view> log_file;
+	bool verbose = false;
+};
+template <>
+struct cli::meta<logging_opts>
+{
+	using T = logging_opts;
+	constexpr static auto value = args{&T::log_file, &T::verbose};
+};
+
+struct tls_opts
+{
+	std::optional<std::string_view> cert;
+	bool insecure = false;
+};
+template <>
+struct cli::meta<tls_opts>
+{
+	using T = tls_opts;
+	constexpr static auto value = args{&T::cert, &T::insecure};
+};
+
+struct rpc_opts
+{
+	std::optional<int> port;
+	std::optional<std::string_view> host;
+	tls_opts tls;
+};
+template <>
+struct cli::meta<rpc_opts>
+{
+	using T = rpc_opts;
+	constexpr static auto value = args{&T::port, &T::host, &T::tls};
+};
+
+struct server_cli
+{
+	std::string_view config;
+	logging_opts logging;
+	std::optional<int> workers;
+	rpc_opts rpc;
+};
+template <>
+struct cli::meta<server_cli>
+{
+	using T = server_cli;
+	constexpr static auto value = args{&T::config, &T::logging, &T::workers, &T::rpc};
+};
+
+TEST_CASE("Option groups")
+{
+	constexpr std::array args{"main", "-v", "server.toml", "--port", "8080", "-w", "4",
+	                          "--log-file=out.log", "--host", "localhost", "-i"};
+	const auto result = cli::parse<server_cli>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(result->config == "server.toml");
+	CHECK(result->logging.verbose);
+	CHECK(result->logging.log_file == "out.log");
+	CHECK(result->workers == 4);
+	CHECK(result->rpc.port == 8080);
+	CHECK(result->rpc.host == "localhost");
+	CHECK(result->rpc.tls.insecure);
+	CHECK(!result->rpc.tls.cert);
+}
+
+TEST_CASE("Option groups (failure)")
+{
+	// Duplicates are detected across groups
+	constexpr std::array duplicate{"main", "server.toml", "--port", "1", "--port", "2"};
+	CHECK(!cli::parse<server_cli>(duplicate.size(), duplicate.data()));
+
+	constexpr std::array missing{"main", "--port", "1"};
+	CHECK(!cli::parse<server_cli>(missing.size(), missing.data()));
+}
+
+TEST_CASE("Lazy parsing")
+{
+	constexpr std::array args{"main", "server.toml", "--port", "80", "-w", "notanint", "-v",
+	                          "--host", "localhost"};
+	std::string errors;
+	auto result = cli::parse_lazy<server_cli>(args.size(), args.data(), std::back_inserter(errors));
+	REQUIRE(result);
+	// Nothing is converted yet, so the bad value isn't noticed
+	CHECK(errors.empty());
+
+	const auto config = result->get<&server_cli::config>();
+	REQUIRE(config);
+	CHECK(*config == "server.toml");
+
+	const auto logging = result->get<&server_cli::logging>();
+	REQUIRE(logging);
+	CHECK(logging->verbose);
+	CHECK(!logging->log_file);
+
+	const auto rpc = result->get<&server_cli::rpc>();
+	REQUIRE(rpc);
+	CHECK(rpc->port == 80);
+	CHECK(rpc->host == "localhost");
+
+	CHECK(result->get<&server_cli::workers>() == nullptr);
+	CHECK(errors == "Not a number (notanint)");
+	// Errors are only reported once
+	CHECK(result->get<&server_cli::workers>() == nullptr);
+	CHECK(errors == "Not a number (notanint)");
+}
+
+TEST_CASE("Lazy parsing (failure)")
+{
+	constexpr std::array missing_value{"main", "server.toml", "--port"};
+	CHECK(!cli::parse_lazy<server_cli>(missing_value.size(), missing_value.data()));
+
+	constexpr std::array duplicate{"main", "server.toml", "-w", "1", "-w", "2"};
+	CHECK(!cli::parse_lazy<server_cli>(duplicate.size(), duplicate.data()));
+
+	constexpr std::array missing_positional{"main", "-w", "1"};
+	CHECK(!cli::parse_lazy<server_cli>(missing_positional.size(), missing_positional.data()));
+}
+
+TEST_CASE("Validate")
+{
+	constexpr std::array good{"main", "server.toml", "--port", "80", "-v"};
+	const auto result = cli::validate<server_cli>(good.size(), good.data());
+	CHECK(result);
+
+	constexpr std::array bad_number{"main", "server.toml", "-v", "--port=80000000000"};
+	const auto bad_number_result = cli::validate<server_cli>(bad_number.size(), bad_number.data());
+	CHECK(!bad_number_result);
+	CHECK(bad_number_result.error_index == 3);
+
+	constexpr std::array unknown{"main", "server.toml", "--bogus"};
+	const auto unknown_result = cli::validate<server_cli>(unknown.size(), unknown.data());
+	CHECK(!unknown_result);
+	CHECK(unknown_result.error_index == 2);
+
+	constexpr std::array missing{"main", "-v"};
+	const auto missing_result = cli::validate<server_cli>(missing.size(), missing.data());
+	CHECK(!missing_result);
+	CHECK(missing_result.error_index == 2);
+}
+
+TEST_CASE("Validate (sets)")
+{
+	constexpr std::array good{"main", "--ints", "1", "--ints", "2", "--ints", "1"};
+	CHECK(cli::validate<sets>(good.size(), good.data()));
+
+	constexpr std::array bad{"main", "--ints", "1", "--ints", "x"};
+	const auto result = cli::validate<sets>(bad.size(), bad.data());
+	CHECK(!result);
+	CHECK(result.error_index == 3);
+}
+
+// Writes value with to_argv, and parses it back.
+template <class T>
+auto round_trip(const T& value) -> std::optional<T>
+{
+	std::array<char, 1024> buffer{};
+	std::array<char*, 64> out{};
+	const auto argc = cli::to_argv(value, "main", buffer, out);
+	if (!argc)
+	{
+		return {};
+	}
+	return cli::parse<T>(*argc, out.data());
+}
+
+TEST_CASE("to_argv")
+{
+	constexpr std::array args{"main", "--", "-5", "--not-a-keyword", "-7", "--", "-8.5", "-bob"};
+	std::array<char, 256> buffer{};
+	std::array<char*, 16> out{};
+	const auto value = cli::parse<positional_only>(args.size(), args.data());
+	REQUIRE(value);
+
+	const auto argc = cli::to_argv(*value, "main", buffer, out);
+	REQUIRE(argc == 8);
+	for (std::size_t i = 0; i < args.size(); ++i)
+	{
+		CHECK(std::string_view{out[i]} == args[i]);
+	}
+	// Tokens are contiguous
+	CHECK(out[1] == buffer.data() + 5);
+	CHECK(out[8] == nullptr);
+}
+
+TEST_CASE("to_argv (keywords)")
+{
+	const server_cli value{
+		.config = "server.toml",
+		.logging = {.log_file = "out.log", .verbose = true},
+		.workers = -4,
+		.rpc = {.port = 8080, .host = {}, .tls = {.cert = {}, .insecure = true}},
+	};
+
+	std::array<char, 256> buffer{};
+	std::array<char*, 16> out{};
+	const auto argc = cli::to_argv(value, "main", buffer, out);
+	REQUIRE(argc == 8);
+	CHECK(std::string_view{out[1]} == "--log-file=out.log");
+	CHECK(std::string_view{out[2]} == "--verbose");
+	CHECK(std::string_view{out[3]} == "--workers=-4");
+	CHECK(std::string_view{out[4]} == "--port=8080");
+	CHECK(std::string_view{out[5]} == "--insecure");
+	CHECK(std::string_view{out[6]} == "--");
+	CHECK(std::string_view{out[7]} == "server.toml");
+
+	const auto result = cli::parse<server_cli>(*argc, out.data());
+	REQUIRE(result);
+	CHECK(result->config == value.config);
+	CHECK(result->logging.log_file == value.logging.log_file);
+	CHECK(result->logging.verbose);
+	CHECK(result->workers == value.workers);
+	CHECK(result->rpc.port == value.rpc.port);
+	CHECK(!result->rpc.host);
+	CHECK(result->rpc.tls.insecure);
 }
+
+TEST_CASE("to_argv (round trip)")
+{
+	const sets set_value{.ints = {3, -1, 7}, .strs = {"a", "-b"}};
+	const auto sets_result = round_trip(set_value);
+	REQUIRE(sets_result);
+	CHECK(sets_result->ints == set_value.ints);
+	CHECK(sets_result->strs == set_value.strs);
+
+	const pairs pair_value{.first = {-1, "x"}, .second = std::pair{2, 0.1}};
+	const auto pairs_result = round_trip(pair_value);
+	REQUIRE(pairs_result);
+	CHECK(pairs_result->first == pair_value.first);
+	CHECK(pairs_result->second == pair_value.second);
+
+	const tuples tuple_value{.value = std::tuple{1, "two", 1e300}};
+	const auto tuples_result = round_trip(tuple_value);
+	REQUIRE(tuples_result);
+	CHECK(tuples_result->value == tuple_value.value);
+
+	const enums enum_value{
+		.level = log_level::warning_only,
+		.codec_ = codec::av1,
+		.features = static_cast<feature>(static_cast<unsigned>(feature::simd) |
+		                                 static_cast<unsigned>(feature::huge_pages)),
+		.allowed_codecs = cli::enum_bitset<codec>{}.set(codec::h264).set(codec::vp9),
+	};
+	const auto enums_result = round_trip(enum_value);
+	REQUIRE(enums_result);
+	CHECK(enums_result->level == enum_value.level);
+	CHECK(enums_result->codec_ == enum_value.codec_);
+	CHECK(enums_result->features == enum_value.features);
+	CHECK(enums_result->allowed_codecs == enum_value.allowed_codecs);
+
+	bit_flags flag_value;
+	flag_value.f.set(42);
+	flag_value.w = 0b001;
+	const auto flags_result = round_trip(flag_value);
+	REQUIRE(flags_result);
+	CHECK(flags_result->f == flag_value.f);
+	CHECK(flags_result->w == flag_value.w);
+	CHECK(!flags_result->verbose);
+
+	constexpr std::array command{"./worker", "--verbose"};
+	const launcher launcher_value{.cpus = 2, .verbose = false, .command = command};
+	const auto launcher_result = round_trip(launcher_value);
+	REQUIRE(launcher_result);
+	CHECK(launcher_result->cpus == 2);
+	REQUIRE(launcher_result->command.size() == 2);
+	CHECK(std::string_view{launcher_result->command[1]} == "--verbose");
+}
+
+TEST_CASE("to_argv (failure)")
+{
+	const server_cli value{.config = "server.toml", .logging = {}, .workers = 4, .rpc = {}};
+
+	std::array<char, 16> small_buffer{};
+	std::array<char*, 16> out{};
+	CHECK(!cli::to_argv(value, "main", small_buffer, out));
+
+	std::array<char, 256> buffer{};
+	std::array<char*, 4> small_out{};
+	CHECK(!cli::to_argv(value, "main", buffer, small_out));
+
+	// Can't be given as a multi-value option
+	constexpr std::array files{"a.txt", "-b.txt"};
+	const multi_values multi_value{.count = {}, .files = files, .sizes = {}};
+	CHECK(!cli::to_argv(multi_value, "main", buffer, out));
+}
+
+struct launch_opts
+{
+	std::string_view input;
+	std::optional<int> n;
+};
+template <>
+struct cli::meta<launch_opts>
+{
+	using T = launch_opts;
+	constexpr static auto value = args{&T::input, &T::n};
+};
+
+TEST_CASE("Unknown args passthrough")
+{
+	constexpr std::array args{"main", "--xla-flags=fast", "-n", "5", "--gpu", "0", "in.txt",
+	                          "-q", "--", "extra"};
+	std::array<char*, args.size()> out{};
+
+	const auto result = cli::parse_known<launch_opts>(args.size(), args.data(), out.data());
+	REQUIRE(result);
+	CHECK(result->value.n == 5);
+	CHECK(result->value.input == "in.txt");
+
+	REQUIRE(result->argc == 7);
+	CHECK(std::string_view{out[0]} == "main");
+	CHECK(std::string_view{out[1]} == "--xla-flags=fast");
+	CHECK(std::string_view{out[2]} == "--gpu");
+	CHECK(std::string_view{out[3]} == "0");
+	CHECK(std::string_view{out[4]} == "-q");
+	CHECK(std::string_view{out[5]} == "--");
+	CHECK(std::string_view{out[6]} == "extra");
+
+	// Positionals after "--" stay positional for the next parser
+	constexpr std::array keyword_like{"main", "-n", "1", "in.txt", "--", "--foo", "bar"};
+	std::array<char*, keyword_like.size()> rest{};
+	const auto keyword_like_result =
+		cli::parse_known<launch_opts>(keyword_like.size(), keyword_like.data(), rest.data());
+	REQUIRE(keyword_like_result);
+	REQUIRE(keyword_like_result->argc == 4);
+	CHECK(std::string_view{rest[1]} == "--");
+	CHECK(std::string_view{rest[2]} == "--foo");
+	CHECK(std::string_view{rest[3]} == "bar");
+}
+
+TEST_CASE("Unknown args passthrough (in place)")
+{
+	std::array<char, 6> name{"main"}, flag{"--foo"}, n{"-n"}, value{"3"}, input{"x"};
+	std::array argv{name.data(), flag.data(), n.data(), value.data(), input.data()};
+
+	const auto result =
+		cli::parse_known<launch_opts>(static_cast<int>(argv.size()), argv.data(), argv.data());
+	REQUIRE(result);
+	CHECK(result->value.n == 3);
+	CHECK(result->value.input == "x");
+	REQUIRE(result->argc == 2);
+	CHECK(argv[1] == flag.data());
+}
+
+struct build_cmd
+{
+	std::string_view target;
+	std::optional<int> jobs;
+};
+template <>
+struct cli::meta<build_cmd>
+{
+	using T = build_cmd;
+	constexpr static std::string_view name = "build";
+	constexpr static auto value = args{&T::target, &T::jobs};
+};
+
+struct push
+{
+	std::optional<std::string_view> remote;
+	bool force = false;
+};
+template <>
+struct cli::meta<push>
+{
+	using T = push;
+	constexpr static auto value = args{&T::remote, &T::force};
+};
+
+struct remote_add
+{
+	std::string_view name;
+	std::string_view url;
+};
+template <>
+struct cli::meta<remote_add>
+{
+	using T = remote_add;
+	constexpr static std::string_view name = "add";
+	constexpr static auto value = args{&T::name, &T::url};
+};
+
+struct remote_remove
+{
+	std::string_view name;
+};
+template <>
+struct cli::meta<remote_remove>
+{
+	using T = remote_remove;
+	constexpr static std::string_view name = "remove";
+	constexpr static auto value = args{&T::name};
+};
+
+struct remote
+{
+	bool verbose = false;
+	std::variant<remote_add, remote_remove> command;
+};
+template <>
+struct cli::meta<remote>
+{
+	using T = remote;
+	constexpr static auto value = args{&T::verbose, &T::command};
+};
+
+using tool = std::variant<build_cmd, push, remote>;
+
+TEST_CASE("Subcommands")
+{
+	constexpr std::array args{"main", "build", "--jobs", "8", "all"};
+	const auto result = cli::parse<tool>(args.size(), args.data());
+	REQUIRE(result);
+
+	const auto& build = std::get<build_cmd>(result.value());
+	CHECK(build.target == "all");
+	CHECK(build.jobs == 8);
+}
+
+TEST_CASE("Subcommands (reflected name)")
+{
+	constexpr std::array args{"main", "push", "-f", "-r", "origin"};
+	const auto result = cli::parse<tool>(args.size(), args.data());
+	REQUIRE(result);
+
+	const auto& cmd = std::get<push>(result.value());
+	CHECK(cmd.force);
+	CHECK(cmd.remote == "origin");
+}
+
+TEST_CASE("Subcommands (nested)")
+{
+	constexpr std::array args{"main", "remote", "-v", "add", "origin", "https://example.com"};
+	const auto result = cli::parse<tool>(args.size(), args.data());
+	REQUIRE(result);
+
+	const auto& cmd = std::get<remote>(result.value());
+	CHECK(cmd.verbose);
+	const auto& add = std::get<remote_add>(cmd.command);
+	CHECK(add.name == "origin");
+	CHECK(add.url == "https://example.com");
+}
+
+TEST_CASE("Subcommands (failure)")
+{
+	constexpr std::array missing{"main"};
+	CHECK(!cli::parse<tool>(missing.size(), missing.data()));
+
+	constexpr std::array unknown{"main", "pull"};
+	CHECK(!cli::parse<tool>(unknown.size(), unknown.data()));
+
+	constexpr std::array missing_nested{"main", "remote", "-v"};
+	CHECK(!cli::parse<tool>(missing_nested.size(), missing_nested.data()));
+
+	constexpr std::array bad_nested{"main", "remote", "remove", "a", "b"};
+	CHECK(!cli::parse<tool>(bad_nested.size(), bad_nested.data()));
+}
+
+TEST_CASE("Validate (subcommands)")
+{
+	constexpr std::array good{"main", "-v", "add", "origin", "u"};
+	CHECK(cli::validate<remote>(good.size(), good.data()));
+
+	// The command's own args are checked
+	constexpr std::array extra{"main", "remove", "origin", "u"};
+	const auto extra_result = cli::validate<remote>(extra.size(), extra.data());
+	CHECK(!extra_result);
+	CHECK(extra_result.error_index == 1);
+
+	std::string errors;
+	constexpr std::array unknown{"main", "-v", "rename", "origin"};
+	const auto unknown_result =
+		cli::validate<remote>(unknown.size(), unknown.data(), std::back_inserter(errors));
+	CHECK(!unknown_result);
+	CHECK(unknown_result.error_index == 2);
+	CHECK(errors == "Unknown subcommand rename");
+}
+
+template <class T>
+auto dump(const T& value, bool json) -> std::string
+{
+	std::string result;
+	if (json)
+	{
+		cli::compat::format_to(std::back_inserter(result), "{:j}", cli::dump_formatter<T>{value});
+	}
+	else
+	{
+		cli::compat::format_to(std::back_inserter(result), "{}", cli::dump_formatter<T>{value});
+	}
+	return result;
+}
+
+TEST_CASE("Dump")
+{
+	const server_cli value{
+		.config = "dir\\server \"1\".toml",
+		.logging = {.log_file = {}, .verbose = true},
+		.workers = 4,
+		.rpc = {.port = 8080, .host = "local\nhost", .tls = {}},
+	};
+
+	CHECK(dump(value, false) == "config=dir\\\\server \\\"1\\\".toml\n"
+	                            "log-file=\n"
+	                            "verbose=true\n"
+	                            "workers=4\n"
+	                            "port=8080\n"
+	                            "host=local\\nhost\n"
+	                            "cert=\n"
+	                            "insecure=false");
+	CHECK(dump(value, true) ==
+	      R"({"config":"dir\\server \"1\".toml","log-file":null,"verbose":true,"workers":4,)"
+	      R"("port":8080,"host":"local\nhost","cert":null,"insecure":false})");
+}
+
+TEST_CASE("Dump (containers and enums)")
+{
+	const enums enum_value{
+		.level = log_level::warning_only,
+		.codec_ = {},
+		.features = static_cast<feature>(static_cast<unsigned>(feature::simd) |
+		                                 static_cast<unsigned>(feature::huge_pages)),
+		.allowed_codecs = cli::enum_bitset<codec>{}.set(codec::h264).set(codec::vp9),
+	};
+	CHECK(dump(enum_value, true) ==
+	      R"({"level":"warning-only","codec":null,"features":["simd","huge-pages"],)"
+	      R"("allowed-codecs":["h264","vp9"]})");
+	CHECK(dump(enum_value, false) == "level=warning-only\ncodec=\nfeatures=simd,huge-pages\n"
+	                                 "allowed-codecs=h264,vp9");
+
+	const sets set_value{.ints = {3, 1}, .strs = {}};
+	CHECK(dump(set_value, true) == R"({"ints":[1,3],"strs":[]})");
+
+	const pairs pair_value{.first = {-1, "x"}, .second = std::pair{2, 0.5}};
+	CHECK(dump(pair_value, true) == R"({"first":[-1,"x"],"second":[2,0.5]})");
+
+	// JSON has no inf or nan
+	const pairs inf_value{.first = {1, "y"},
+	                      .second = std::pair{2, std::numeric_limits<double>::infinity()}};
+	CHECK(dump(inf_value, true) == R"({"first":[1,"y"],"second":[2,null]})");
+	const pairs nan_value{.first = {1, "y"},
+	                      .second = std::pair{2, std::numeric_limits<double>::quiet_NaN()}};
+	CHECK(dump(nan_value, true) == R"({"first":[1,"y"],"second":[2,null]})");
+
+	bit_flags flags;
+	flags.f.set(42);
+	CHECK(dump(flags, false) == "fomit-frame-pointer=false\nfstrict-aliasing=true\n"
+	                            "funroll-loops=false\nwarn-all=false\nwarn-error=true\n"
+	                            "verbose=false");
+}
+
+struct small_ints
+{
+	char ch;
+	signed char sch;
+	unsigned char uch;
+};
+
+template <>
+struct cli::meta<small_ints>
+{
+	using T = small_ints;
+	constexpr static auto value = args{&T::ch, &T::sch, &T::uch};
+};
+
+TEST_CASE("Dump (chars)")
+{
+	constexpr std::array args{"main", "65", "-3", "200"};
+	const auto result = cli::parse<small_ints>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->ch == 'A');
+
+	// Written as numbers, so they parse back
+	CHECK(dump(*result, false) == "ch=65\nsch=-3\nuch=200");
+	CHECK(dump(*result, true) == R"({"ch":65,"sch":-3,"uch":200})");
+}
+
+TEST_CASE("Dump (subcommands)")
+{
+	const remote value{.verbose = true, .command = remote_add{.name = "origin", .url = "u"}};
+	CHECK(dump(value, true) ==
+	      R"({"verbose":true,"command":{"add":{"name":"origin","url":"u"}}})");
+	CHECK(dump(value, false) == "verbose=true\ncommand=add\nadd.name=origin\nadd.url=u");
+}
+
+TEST_CASE("Events")
+{
+	constexpr std::array args{"main", "--ints", "3", "--strs", "a", "--ints", "1", "--ints", "3"};
+	std::vector<int> ints;
+	std::vector<std::string_view> strs;
+	const auto visitor = [&]<std::size_t I>(std::integral_constant<std::size_t, I>,
+	                                        const auto& value)
+	{
+		if constexpr (I == cli::arg_index<sets, &sets::ints>)
+		{
+			ints.push_back(value);
+		}
+		else
+		{
+			strs.push_back(value);
+		}
+	};
+	CHECK(cli::parse_events<sets>(args.size(), args.data(), visitor));
+	// Every occurrence, in order
+	CHECK(ints == std::vector{3, 1, 3});
+	CHECK(strs == std::vector<std::string_view>{"a"});
+}
+
+TEST_CASE("Events (groups, flags and trailing args)")
+{
+	constexpr std::array server_args{"main", "server.toml", "-i", "--port", "80", "-v"};
+	std::vector<std::size_t> indices;
+	int port = 0;
+	const auto server_visitor =
+		[&]<std::size_t I>(std::integral_constant<std::size_t, I>, const auto& value)
+	{
+		indices.push_back(I);
+		if constexpr (std::is_same_v<std::remove_cvref_t<decltype(value)>, int>)
+		{
+			port = value;
+		}
+	};
+	CHECK(cli::parse_events<server_cli>(server_args.size(), server_args.data(), server_visitor));
+	CHECK(indices == std::vector<std::size_t>{0, 7, 4, 2});
+	CHECK(cli::arg_index<server_cli, &server_cli::rpc> == 4);
+	CHECK(port == 80);
+
+	constexpr std::array launcher_args{"main", "-v", "--", "./worker", "-x"};
+	std::size_t n_trailing = 0;
+	const auto launcher_visitor =
+		[&]<std::size_t I>(std::integral_constant<std::size_t, I>, const auto& value)
+	{
+		if constexpr (I == cli::arg_index<launcher, &launcher::command>)
+		{
+			n_trailing = value.size();
+		}
+	};
+	CHECK(
+		cli::parse_events<launcher>(launcher_args.size(), launcher_args.data(), launcher_visitor));
+	CHECK(n_trailing == 2);
+}
+
+TEST_CASE("Events (failure)")
+{
+	const auto ignore = [](auto, const auto&) {};
+
+	constexpr std::array duplicate{"main", "server.toml", "-w", "1", "-w", "2"};
+	CHECK(!cli::parse_events<server_cli>(duplicate.size(), duplicate.data(), ignore));
+
+	constexpr std::array missing{"main", "-w", "1"};
+	CHECK(!cli::parse_events<server_cli>(missing.size(), missing.data(), ignore));
+
+	constexpr std::array bad_number{"main", "--ints", "1", "--ints", "x"};
+	int n_events = 0;
+	CHECK(!cli::parse_events<sets>(bad_number.size(), bad_number.data(),
+	                               [&](auto, const auto&) { ++n_events; }));
+	CHECK(n_events == 1);
+}
+
+TEST_CASE("Runtime options")
+{
+	std::array<cli::registered_option, 8> slots;
+	cli::option_registry registry{slots};
+
+	int level = 0;
+	bool trace = false;
+	std::set<std::string_view> paths;
+	CHECK(registry.add("level", level));
+	CHECK(registry.add("trace", trace));
+	CHECK(registry.add("path", paths));
+	CHECK(!registry.add("level", trace));
+	CHECK(registry.find("trace") != nullptr);
+	CHECK(registry.find("tracer") == nullptr);
+
+	// Static args come first
+	bool static_verbose = false;
+	CHECK(registry.add("verbose", static_verbose));
+
+	constexpr std::array args{"main",   "server.toml", "--level=3", "--path", "a",       "--trace",
+	                          "--path", "b",           "--port",    "80",     "--verbose"};
+	const auto result = cli::parse_dynamic<server_cli>(args.size(), args.data(), registry);
+	REQUIRE(result);
+	CHECK(result->config == "server.toml");
+	CHECK(result->rpc.port == 80);
+	CHECK(result->logging.verbose);
+	CHECK(!static_verbose);
+	CHECK(level == 3);
+	CHECK(trace);
+	CHECK(paths == std::set<std::string_view>{"a", "b"});
+
+	// Repeating a registered option isn't an error, the last value is kept
+	constexpr std::array repeated{"main", "server.toml", "--level", "1", "--level=5"};
+	CHECK(cli::parse_dynamic<server_cli>(repeated.size(), repeated.data(), registry));
+	CHECK(level == 5);
+
+	// Registered options only see their own arg
+	static_assert(cli::detail::takes_single_value<std::optional<int>>());
+	static_assert(cli::detail::takes_single_value<std::set<std::array<int, 1>>>());
+	static_assert(!cli::detail::takes_single_value<std::pair<int, int>>());
+	static_assert(!cli::detail::takes_single_value<std::optional<std::tuple<int, int>>>());
+	static_assert(!cli::detail::takes_single_value<std::variant<build_cmd, push>>());
+}
+
+TEST_CASE("Runtime options (failure)")
+{
+	std::array<cli::registered_option, 4> slots;
+	cli::option_registry registry{slots};
+
+	int level = 0;
+	int other = 0;
+	CHECK(registry.add("level", level));
+	CHECK(registry.add("other", other));
+	CHECK(registry.add("third", other));
+	// Over 3/4 full
+	CHECK(!registry.add("fourth", other));
+
+	std::string errors;
+	constexpr std::array bad{"main", "server.toml", "--level", "high"};
+	CHECK(!cli::parse_dynamic<server_cli>(bad.size(), bad.data(), registry,
+	                                      std::back_inserter(errors)));
+	CHECK(errors == "Invalid value (high) for --level");
+
+	constexpr std::array unknown{"main", "server.toml", "--bogus"};
+	CHECK(!cli::parse_dynamic<server_cli>(unknown.size(), unknown.data(), registry));
+
+	// Only long keywords are looked up
+	constexpr std::array short_form{"main", "server.toml", "-level", "1"};
+	CHECK(!cli::parse_dynamic<server_cli>(short_form.size(), short_form.data(), registry));
+}
+
+struct prefixed
+{
+	std::optional<int> threads;
+	std::optional<int> three;
+	bool verbose = false;
+	std::optional<std::string_view> verb;
+};
+template <>
+struct cli::meta<prefixed>
+{
+	using T = prefixed;
+	constexpr static bool allow_prefixes = true;
+	constexpr static auto value = args{
+		&T::threads,
+		arg{&T::three, {.abbr = cli::none}},
+		&T::verbose,
+		arg{&T::verb, {.abbr = cli::none}},
+	};
+};
+
+TEST_CASE("Prefix matching")
+{
+	constexpr std::array args{"main", "--threa", "4", "--verbo", "--three=3", "--verb", "x"};
+	const auto result = cli::parse<prefixed>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->threads == 4);
+	CHECK(result->three == 3);
+	CHECK(result->verbose);
+	// An exact name wins over the longer names it's a prefix of
+	CHECK(result->verb == "x");
+
+	// Not enabled by default
+	constexpr std::array other{"main", "--verb"};
+	CHECK(!cli::parse<launcher>(other.size(), other.data()));
+}
+
+TEST_CASE("Prefix matching (failure)")
+{
+	std::string errors;
+	constexpr std::array ambiguous{"main", "--thre", "4"};
+	CHECK(!cli::parse<prefixed>(ambiguous.size(), ambiguous.data(), std::back_inserter(errors)));
+	CHECK(errors == "Ambiguous keyword argument thre, could be --threads --three");
+
+	errors.clear();
+	constexpr std::array ambiguous_exact{"main", "--ver"};
+	CHECK(!cli::parse<prefixed>(ambiguous_exact.size(), ambiguous_exact.data(),
+	                            std::back_inserter(errors)));
+	CHECK(errors == "Ambiguous keyword argument ver, could be --verb --verbose");
+
+	constexpr std::array unknown{"main", "--x"};
+	CHECK(!cli::parse<prefixed>(unknown.size(), unknown.data()));
+}
+
+struct compiler_driver
+{
+	std::optional<int> opt_level;
+	std::set<std::string_view> defines;
+	std::set<std::string_view> include_dirs;
+	std::set<std::string_view> warnings;
+	std::set<std::string_view> disabled_warnings;
+	bool verbose = false;
+};
+template <>
+struct cli::meta<compiler_driver>
+{
+	using T = compiler_driver;
+	constexpr static auto value = args{
+		arg{&T::opt_level, {.prefix = "O"}},
+		arg{&T::defines, {.prefix = "D"}},
+		arg{&T::include_dirs, {.prefix = "I"}},
+		arg{&T::warnings, {.prefix = "W"}},
+		arg{&T::disabled_warnings, {.prefix = "Wno-"}},
+		&T::verbose,
+	};
+};
+
+TEST_CASE("Prefix families")
+{
+	constexpr std::array args{"main",  "-O2",   "-DNDEBUG",    "-DLEVEL=3", "-I/usr/include", "-I",
+	                          "include", "-Wall", "-Wno-unused", "-v",        "--defines=X"};
+	const auto result = cli::parse<compiler_driver>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->opt_level == 2);
+	CHECK(result->defines == std::set<std::string_view>{"NDEBUG", "LEVEL=3", "X"});
+	CHECK(result->include_dirs == std::set<std::string_view>{"/usr/include", "include"});
+	CHECK(result->warnings == std::set<std::string_view>{"all"});
+	CHECK(result->disabled_warnings == std::set<std::string_view>{"unused"});
+	CHECK(result->verbose);
+}
+
+TEST_CASE("Prefix families (failure)")
+{
+	constexpr std::array duplicate{"main", "-O2", "-O3"};
+	CHECK(!cli::parse<compiler_driver>(duplicate.size(), duplicate.data()));
+
+	constexpr std::array not_a_number{"main", "-Ofast"};
+	CHECK(!cli::parse<compiler_driver>(not_a_number.size(), not_a_number.data()));
+
+	constexpr std::array missing_value{"main", "-I"};
+	CHECK(!cli::parse<compiler_driver>(missing_value.size(), missing_value.data()));
+
+	constexpr std::array unknown{"main", "-Xlinker"};
+	CHECK(!cli::parse<compiler_driver>(unknown.size(), unknown.data()));
+}
+
+TEST_CASE("Suggestions")
+{
+	std::string errors;
+	constexpr std::array typo{"main", "server.toml", "--verbse"};
+	CHECK(!cli::parse<server_cli>(typo.size(), typo.data(), std::back_inserter(errors)));
+	CHECK(errors == "Unrecognized keyword argument verbse, did you mean --verbose?");
+
+	errors.clear();
+	constexpr std::array far{"main", "server.toml", "--quiet"};
+	CHECK(!cli::parse<server_cli>(far.size(), far.data(), std::back_inserter(errors)));
+	CHECK(errors == "Unrecognized keyword argument quiet");
+
+	// Short keywords aren't compared to long names
+	errors.clear();
+	constexpr std::array short_typo{"main", "server.toml", "-x"};
+	CHECK(
+		!cli::parse<server_cli>(short_typo.size(), short_typo.data(), std::back_inserter(errors)));
+	CHECK(errors == "Unrecognized keyword argument x");
+
+	std::string formatted;
+	cli::compat::format_to(
+		std::back_inserter(formatted), "{}",
+		cli::error_formatter<server_cli>{{cli::error_type::invalid_key, 2}, 3, typo.data()});
+	CHECK(formatted.starts_with(
+		"Error: Unknown option \"--verbse\". Did you mean --verbose? Available options:\n"));
+}
+
+TEST_CASE("Edit distance")
+{
+	const cli::detail::edit_pattern pattern{"kitten"};
+	CHECK(pattern.distance("sitting") == 3);
+	CHECK(pattern.distance("kitten") == 0);
+	CHECK(pattern.distance("") == 6);
+	CHECK(cli::detail::edit_pattern{""}.distance("abc") == 3);
+	CHECK(cli::detail::edit_pattern{"flaw"}.distance("lawn") == 2);
+}
+
+struct renamed
+{
+	std::optional<int> threads;
+	bool dry_run = false;
+};
+template <>
+struct cli::meta<renamed>
+{
+	using T = renamed;
+	constexpr static auto value = args{
+		arg{&T::threads, {.aliases = "--num-threads -j"}},
+		arg{&T::dry_run, {.aliases = "--simulate"}},
+	};
+};
+
+struct loose
+{
+	std::optional<int> num_threads;
+	bool dry_run = false;
+};
+template <>
+struct cli::meta<loose>
+{
+	using T = loose;
+	constexpr static bool loose_keywords = true;
+	constexpr static auto value = args{
+		arg{&T::num_threads, {.aliases = "--Jobs"}},
+		&T::dry_run,
+	};
+};
+
+TEST_CASE("Aliases")
+{
+	constexpr std::array args{"main", "--num-threads=4", "--simulate"};
+	const auto result = cli::parse<renamed>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->threads == 4);
+	CHECK(result->dry_run);
+
+	constexpr std::array short_alias{"main", "-j", "2"};
+	const auto short_result = cli::parse<renamed>(short_alias.size(), short_alias.data());
+	REQUIRE(short_result);
+	CHECK(short_result->threads == 2);
+
+	// Aliases are the same argument
+	constexpr std::array duplicate{"main", "--threads=1", "-j", "2"};
+	CHECK(!cli::parse<renamed>(duplicate.size(), duplicate.data()));
+
+	// Exact by default
+	constexpr std::array wrong_case{"main", "--Threads=1"};
+	CHECK(!cli::parse<renamed>(wrong_case.size(), wrong_case.data()));
+}
+
+TEST_CASE("Loose keywords")
+{
+	constexpr std::array args{"main", "--Num_Threads", "8", "--DRY-RUN"};
+	const auto result = cli::parse<loose>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->num_threads == 8);
+	CHECK(result->dry_run);
+
+	constexpr std::array alias{"main", "--jobs=3"};
+	const auto alias_result = cli::parse<loose>(alias.size(), alias.data());
+	REQUIRE(alias_result);
+	CHECK(alias_result->num_threads == 3);
+
+	// Short keywords stay exact
+	constexpr std::array short_upper{"main", "-D"};
+	CHECK(!cli::parse<loose>(short_upper.size(), short_upper.data()));
+
+	constexpr std::array other{"main", "--num.threads=1"};
+	CHECK(!cli::parse<loose>(other.size(), other.data()));
+}
+
+struct loose_prefixed
+{
+	bool verbose = false;
+	std::optional<int> level;
+};
+template <>
+struct cli::meta<loose_prefixed>
+{
+	using T = loose_prefixed;
+	constexpr static bool allow_prefixes = true;
+	constexpr static bool loose_keywords = true;
+	constexpr static auto value = args{
+		&T::verbose,
+		arg{&T::level, {.aliases = "--verbosity"}},
+	};
+};
+
+TEST_CASE("Prefix matching (aliases and loose keywords)")
+{
+	constexpr std::array args{"main", "--Verbosi", "2", "--VERBOSE"};
+	const auto result = cli::parse<loose_prefixed>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->level == 2);
+	CHECK(result->verbose);
+
+	// Names of the same argument don't make each other ambiguous
+	constexpr std::array own_alias{"main", "--lev=1"};
+	const auto own_alias_result = cli::parse<loose_prefixed>(own_alias.size(), own_alias.data());
+	REQUIRE(own_alias_result);
+	CHECK(own_alias_result->level == 1);
+
+	std::string errors;
+	constexpr std::array ambiguous{"main", "--Verb"};
+	CHECK(!cli::parse<loose_prefixed>(ambiguous.size(), ambiguous.data(),
+	                                  std::back_inserter(errors)));
+	CHECK(errors == "Ambiguous keyword argument Verb, could be --verbose --verbosity");
+
+	errors.clear();
+	constexpr std::array typo{"main", "--Verbosiyt", "2"};
+	CHECK(!cli::parse<loose_prefixed>(typo.size(), typo.data(), std::back_inserter(errors)));
+	CHECK(errors == "Unrecognized keyword argument Verbosiyt, did you mean --verbosity?");
+}
+
+struct digit_flag
+{
+	std::optional<int> value;
+	bool one = false;
+};
+template <>
+struct cli::meta<digit_flag>
+{
+	using T = digit_flag;
+	constexpr static auto value = args{&T::value, arg{&T::one, {.abbr = "1"}}};
+};
+
+TEST_CASE("Negative numbers")
+{
+	constexpr std::array args{"main", "-5", "-", "-12", "bob", "-.5", "--", "-x"};
+	const auto result = cli::parse<positional_only>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->arg1 == -5);
+	CHECK(result->arg2 == "-");
+	CHECK(result->arg3 == -12);
+	CHECK(result->arg4 == "bob");
+	CHECK(result->arg5 == -0.5);
+	CHECK(result->arg6 == "-x");
+
+	// Unless they could be short names
+	constexpr std::array flag{"main", "-1", "-v", "-2"};
+	const auto flag_result = cli::parse<digit_flag>(flag.size(), flag.data());
+	REQUIRE(flag_result);
+	CHECK(flag_result->one);
+	CHECK(flag_result->value == -2);
+
+	constexpr std::array unknown{"main", "-2"};
+	CHECK(!cli::parse<digit_flag>(unknown.size(), unknown.data()));
+}
+
+struct digit_multi
+{
+	cli::values_view<int> sizes;
+	bool one = false;
+};
+template <>
+struct cli::meta<digit_multi>
+{
+	using T = digit_multi;
+	constexpr static auto value = args{&T::sizes, arg{&T::one, {.abbr = "1"}}};
+};
+
+TEST_CASE("Negative numbers (multi-value options)")
+{
+	constexpr std::array args{"main", "--sizes", "-1", "-2", "-", "--count", "3"};
+	const auto result = cli::parse<multi_values>(args.size(), args.data());
+	REQUIRE(result);
+	const auto& sizes = result->sizes;
+	REQUIRE(sizes.size() == 3);
+	CHECK(sizes[0] == -1);
+	CHECK(sizes[1] == -2);
+	CHECK(!sizes[2].has_value());
+	CHECK(result->count == 3);
+
+	std::size_t n_sizes = 0;
+	const auto visitor = [&]<std::size_t I>(std::integral_constant<std::size_t, I>,
+	                                        const auto& value)
+	{
+		if constexpr (I == cli::arg_index<multi_values, &multi_values::sizes>)
+		{
+			n_sizes = value.size();
+		}
+	};
+	CHECK(cli::parse_events<multi_values>(args.size(), args.data(), visitor));
+	CHECK(n_sizes == 3);
+
+	// Unless they could be short names
+	constexpr std::array flag{"main", "--sizes", "4", "-1"};
+	const auto flag_result = cli::parse<digit_multi>(flag.size(), flag.data());
+	REQUIRE(flag_result);
+	CHECK(flag_result->sizes.size() == 1);
+	CHECK(flag_result->one);
+}
+
+TEST_CASE("Token classification")
+{
+	using cli::detail::classify_token;
+	using cli::detail::token_kind;
+	CHECK(classify_token("") == token_kind::positional);
+	CHECK(classify_token("-") == token_kind::positional);
+	CHECK(classify_token("--") == token_kind::terminator);
+	CHECK(classify_token("--x") == token_kind::long_keyword);
+	CHECK(classify_token("-x") == token_kind::short_keyword);
+	CHECK(classify_token("-7") == token_kind::negative_number);
+	CHECK(classify_token("x-") == token_kind::positional);
+
+	// Across blocks
+	std::array<const char*, 200> args{};
+	for (std::size_t i = 0; i < args.size(); ++i)
+	{
+		args[i] = i % 2 == 0 ? "--k" : "v";
+	}
+	cli::detail::token_classifier tokens{static_cast<int>(args.size()), args.data()};
+	for (int i = 0; i < static_cast<int>(args.size()); i += 3)
+	{
+		CHECK(tokens[i] == (i % 2 == 0 ? token_kind::long_keyword : token_kind::positional));
+	}
+}
+
+TEST_CASE("Fingerprint")
+{
+	constexpr std::array args{"main", "server.toml", "--port", "80", "-w", "4", "-v"};
+	constexpr std::array reordered{"main", "-v", "--workers=04", "server.toml", "--port=80"};
+	constexpr std::array different{"main", "server.toml", "--port", "81", "-w", "4", "-v"};
+
+	const auto value = cli::parse<server_cli>(args.size(), args.data());
+	REQUIRE(value);
+	const auto expected = cli::fingerprint(*value);
+
+	CHECK(cli::fingerprint<server_cli>(args.size(), args.data()) == expected);
+	CHECK(cli::fingerprint<server_cli>(reordered.size(), reordered.data()) == expected);
+	CHECK(cli::fingerprint<server_cli>(different.size(), different.data()) != expected);
+
+	// Absent and empty strings differ
+	server_cli empty_host = *value;
+	empty_host.rpc.host = "";
+	CHECK(cli::fingerprint(empty_host) != expected);
+
+	std::string errors;
+	constexpr std::array bad{"main", "server.toml", "-w", "x"};
+	CHECK(!cli::fingerprint<server_cli>(bad.size(), bad.data(), std::back_inserter(errors)));
+	CHECK(errors == "Not a number (x)");
+}
+
+TEST_CASE("Fingerprint (sets)")
+{
+	constexpr std::array args{"main", "--ints", "3", "--ints", "1", "--strs", "a", "--ints", "3"};
+	const sets set_value{.ints = {1, 3}, .strs = {"a"}};
+	CHECK(cli::fingerprint<sets>(args.size(), args.data()) == cli::fingerprint(set_value));
+
+	unordered_sets forward;
+	unordered_sets backward;
+	for (int i = 0; i < 100; ++i)
+	{
+		forward.ints.insert(i);
+		backward.ints.insert(99 - i);
+	}
+	CHECK(cli::fingerprint(forward) == cli::fingerprint(backward));
+	backward.ints.erase(50);
+	CHECK(cli::fingerprint(forward) != cli::fingerprint(backward));
+
+	// The same elements in different fields
+	const sets swapped{.ints = {}, .strs = {"a"}};
+	const sets other{.ints = {1}, .strs = {}};
+	CHECK(cli::fingerprint(swapped) != cli::fingerprint(other));
+}
+
+TEST_CASE("Fingerprint (subcommands)")
+{
+	constexpr std::array args{"main", "remote", "add", "origin", "u"};
+	const tool value =
+		remote{.verbose = false, .command = remote_add{.name = "origin", .url = "u"}};
+	CHECK(cli::fingerprint<tool>(args.size(), args.data()) == cli::fingerprint(value));
+
+	const tool other = remote{.verbose = false, .command = remote_remove{.name = "origin"}};
+	CHECK(cli::fingerprint(value) != cli::fingerprint(other));
+}
+
+// argv backed by strings which can be overwritten, to check that nothing still points into it.
+struct scratch_args
+{
+	std::vector<std::string> storage;
+	std::vector<const char*> args;
+
+	explicit scratch_args(std::vector<std::string> strs) : storage{std::move(strs)}
+	{
+		for (const auto& str : storage)
+		{
+			args.push_back(str.c_str());
+		}
+	}
+
+	auto argc() const -> int { return static_cast<int>(args.size()); }
+
+	auto clobber() -> void
+	{
+		for (auto& str : storage)
+		{
+			std::fill(str.begin(), str.end(), '#');
+		}
+	}
+};
+
+TEST_CASE("Owned parsing")
+{
+	scratch_args argv{{"main", "--files", "a.txt", "b.txt", "-s", "10", "20", "--count=2"}};
+	auto result = cli::parse_owned<multi_values>(argv.argc(), argv.args.data());
+	REQUIRE(result);
+	argv.clobber();
+
+	REQUIRE((*result)->files.size() == 2);
+	CHECK(std::string_view{(*result)->files[0]} == "a.txt");
+	CHECK(std::string_view{(*result)->files[1]} == "b.txt");
+	REQUIRE(result->value().sizes.size() == 2);
+	CHECK(result->value().sizes[1] == 20);
+	CHECK(result->value().count == 2);
+
+	// Moving the result keeps the arena
+	const auto moved = std::move(*result);
+	CHECK(std::string_view{moved->files[1]} == "b.txt");
+}
+
+TEST_CASE("Owned parsing (containers)")
+{
+	scratch_args set_argv{{"main", "-s", "x", "--strs", "yz", "--ints", "3"}};
+	const auto set_result = cli::parse_owned<sets>(set_argv.argc(), set_argv.args.data());
+	REQUIRE(set_result);
+	set_argv.clobber();
+	CHECK((*set_result)->strs == std::set<std::string_view>{"x", "yz"});
+	CHECK((*set_result)->ints == std::set<int>{3});
+
+	scratch_args pair_argv{{"main", "123", "hello"}};
+	const auto pair_result = cli::parse_owned<pairs>(pair_argv.argc(), pair_argv.args.data());
+	REQUIRE(pair_result);
+	pair_argv.clobber();
+	CHECK((*pair_result)->first == std::pair<int, std::string_view>{123, "hello"});
+
+	scratch_args tool_argv{{"main", "remote", "add", "origin", "url"}};
+	const auto tool_result = cli::parse_owned<tool>(tool_argv.argc(), tool_argv.args.data());
+	REQUIRE(tool_result);
+	tool_argv.clobber();
+	const auto& command = std::get<remote_add>(std::get<remote>(**tool_result).command);
+	CHECK(command.name == "origin");
+	CHECK(command.url == "url");
+}
+
+TEST_CASE("Owned parsing (caller buffer)")
+{
+	scratch_args argv{{"main", "--cpus", "4", "--", "./worker", "-x"}};
+	auto result = cli::parse<launcher>(argv.argc(), argv.args.data());
+	REQUIRE(result);
+	const auto size = cli::owned_size(*result);
+
+	// Too small, nothing is copied
+	std::vector<char> small(size - 1);
+	CHECK(!cli::rebase_strings(*result, std::span{small}));
+	CHECK(result->command.data() == argv.args.data() + 4);
+
+	std::vector<char> buffer(size);
+	REQUIRE(cli::rebase_strings(*result, std::span{buffer}));
+	argv.clobber();
+	CHECK(result->cpus == 4);
+	REQUIRE(result->command.size() == 2);
+	CHECK(std::string_view{result->command[0]} == "./worker");
+	CHECK(std::string_view{result->command[1]} == "-x");
+}
+
+TEST_CASE("Constant evaluation")
+{
+	constexpr std::array args{"main", "-v", "server.toml", "--port", "8080", "-w", "4",
+	                          "--log-file=out.log", "-i"};
+	constexpr auto result = cli::parse<server_cli>(args.size(), args.data(), cli::null_sink{});
+	static_assert(result);
+	static_assert(result->config == "server.toml");
+	static_assert(result->logging.verbose);
+	static_assert(result->logging.log_file == "out.log");
+	static_assert(result->workers == 4);
+	static_assert(result->rpc.port == 8080);
+	static_assert(result->rpc.tls.insecure);
+
+	constexpr std::array numbers{"main", "-123", "hello", "--second", "456", "-.345e2"};
+	constexpr auto pair_result =
+		cli::parse<pairs>(numbers.size(), numbers.data(), cli::null_sink{});
+	static_assert(pair_result->first.first == -123);
+	static_assert(pair_result->second->second == -34.5);
+
+	constexpr std::array enum_args{"main", "warning-only", "--features", "simd,huge-pages"};
+	constexpr auto enum_result = cli::parse<enums>(enum_args.size(), enum_args.data(),
+	                                               cli::null_sink{});
+	static_assert(enum_result->level == log_level::warning_only);
+	static_assert(static_cast<unsigned>(enum_result->features) == 0b10001);
+
+	// Typos fail the build
+	constexpr std::array typo{"main", "server.toml", "--prot", "8080"};
+	static_assert(!cli::parse<server_cli>(typo.size(), typo.data(), cli::null_sink{}));
+	constexpr std::array not_a_number{"main", "server.toml", "--port", "x80"};
+	static_assert(!cli::parse<server_cli>(not_a_number.size(), not_a_number.data(),
+	                                      cli::null_sink{}));
+	constexpr std::array out_of_range{"main", "server.toml", "--port", "99999999999"};
+	static_assert(!cli::parse<server_cli>(out_of_range.size(), out_of_range.data(),
+	                                      cli::null_sink{}));
+
+	CHECK(result->config == "server.toml");
+}
+
+// Whether F{}() is a constant expression
+template <class F>
+constexpr bool is_constant = requires { typename std::bool_constant<(F{}(), true)>; };
+
+constexpr auto constant_double(std::string_view str) -> std::errc
+{
+	double out = 0;
+	return cli::detail::constant_from_chars(str, out);
+}
+
+constexpr auto constant_pairs(std::span<const char* const> args) -> std::optional<pairs>
+{
+	return cli::parse<pairs>(static_cast<int>(args.size()), args.data(), cli::null_sink{});
+}
+
+constexpr std::array finite_args{"main", "1", "x", "--second", "2", "-1.5"};
+constexpr std::array infinite_args{"main", "1", "x", "--second", "2", "-Infinity"};
+
+TEST_CASE("Constant evaluation (inf and nan)")
+{
+	// Accepted at runtime, so they can't be rejected at compile time, and aren't evaluated either
+	const auto result = cli::parse<pairs>(infinite_args.size(), infinite_args.data());
+	REQUIRE(result);
+	CHECK(result->second->second == -std::numeric_limits<double>::infinity());
+
+	static_assert(is_constant<decltype([] { return constant_pairs(finite_args); })>);
+	static_assert(!is_constant<decltype([] { return constant_pairs(infinite_args); })>);
+
+	static_assert(is_constant<decltype([] { return constant_double("1.5"); })>);
+	static_assert(!is_constant<decltype([] { return constant_double("inf"); })>);
+	static_assert(!is_constant<decltype([] { return constant_double("NaN"); })>);
+	static_assert(!is_constant<decltype([] { return constant_double("-nan(123)"); })>);
+	static_assert(constant_double("in") == std::errc::invalid_argument);
+}
+
+struct error_log
+{
+	std::vector<std::string> pieces;
+	std::string text;
+};
+
+auto report_error(error_log* log, std::string_view text) -> void
+{
+	log->pieces.emplace_back(text);
+	log->text += text;
+}
+
+TEST_CASE("Custom error sink")
+{
+	error_log log;
+	constexpr std::array args{"main", "server.toml", "--port", "99999999999"};
+	CHECK(!cli::parse<server_cli>(args.size(), args.data(), &log));
+	CHECK(log.text == "Value (99999999999) out of range");
+	CHECK(log.pieces.size() == 3);
+}
+
+#include <cli151/macros.hpp>
+
+struct cli2
+{
+	std::string_view first, middle, last;
+};
+CLI151_CLI(cli2, &T::first, &T::middle, &T::last)
+
+TEST_CASE("Macro definition")
+{
+	constexpr std::array args{"main", "Francesco", "Von", "Pellegreno"};
+	const auto result = cli::parse<cli2>(args.size(), args.data());
+	REQUIRE(result);
+
+	CHECK(result.value().first == "Francesco");
+	CHECK(result.value().middle == "Von");
+	CHECK(result.value().last == "Pellegreno");
+}
+
+struct shared_cli
+{
+	std::string_view name;
+	std::optional<int> count;
+};
+CLI151_CLI(shared_cli, &T::name, &T::count)
+CLI151_DECLARE_PARSER(shared_cli)
+
+TEST_CASE("Shared parser")
+{
+	static_assert(cli::detail::has_shared_parser<shared_cli>::value);
+	static_assert(!cli::detail::has_shared_parser<cli2>::value);
+
+	constexpr std::array args{"main", "widget", "--count", "3"};
+	const auto result = cli::parse<shared_cli>(args.size(), args.data());
+	REQUIRE(result);
+	CHECK(result->name == "widget");
+	CHECK(result->count == 3);
+
+	constexpr std::array missing{"main"};
+	CHECK(!cli::parse<shared_cli>(missing.size(), missing.data()));
+
+	// Other streams still parse in place
+	std::string errors;
+	CHECK(!cli::parse<shared_cli>(missing.size(), missing.data(), std::back_inserter(errors)));
+	CHECK(!errors.empty());
+}
+
+// Usually in a different source file than the tests
+CLI151_DEFINE_PARSER(shared_cli)